@@ -0,0 +1,60 @@
+#include "AllocationCounter.h"
+
+#ifdef SUDOKU_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> nbAllocations(0);
+
+} // namespace
+
+void* operator new(size_t size) {
+	nbAllocations.fetch_add(1, std::memory_order_relaxed);
+	if(void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+bool AllocationCounter::enabled() {
+	return true;
+}
+
+size_t AllocationCounter::count() {
+	return nbAllocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::enabled() {
+	return false;
+}
+
+size_t AllocationCounter::count() {
+	return 0;
+}
+
+#endif
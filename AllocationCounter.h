@@ -0,0 +1,26 @@
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+#include <cstddef>
+
+/**
+ * Counts the heap allocations of the whole program. Counting is only
+ * compiled in with SUDOKU_COUNT_ALLOCATIONS defined (see "make
+ * allocations"), which replaces the global operator new. Otherwise
+ * count() always returns 0.
+ *
+ * enabled() is defined next to the replaced operator new, so it reports
+ * how AllocationCounter.cpp was compiled and not how the caller was.
+ */
+class AllocationCounter {
+
+public:
+
+	/** Whether allocations are counted in this program */
+	static bool enabled();
+
+	/** The number of allocations since the program started */
+	static size_t count();
+};
+
+#endif /* ALLOCATIONCOUNTER_H_ */
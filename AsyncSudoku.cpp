@@ -0,0 +1,121 @@
+#include "AsyncSudoku.h"
+#include <memory>
+
+namespace {
+
+// the pool only takes copyable functions, so the task is shared
+template <typename Outcome>
+using SharedTask = std::shared_ptr<std::packaged_task<Outcome()>>;
+
+template <typename Outcome, typename Job>
+SharedTask<Outcome> makeTask(Job && job) {
+	return std::make_shared<std::packaged_task<Outcome()>>(std::forward<Job>(job));
+}
+
+// runs the task and hands its ready future to the callback
+template <typename Outcome>
+std::function<void()> withCallback(
+		SharedTask<Outcome> task,
+		std::function<void(std::future<Outcome>)> callback
+) {
+	return [task, callback] {
+		std::future<Outcome> outcome(task->get_future());
+		(*task)();
+		callback(std::move(outcome));
+	};
+}
+
+} // namespace
+
+AsyncSudoku::AsyncSudoku(size_t nbThreads, size_t maxQueueDepth) :
+		m_pool(nbThreads, maxQueueDepth)
+{}
+
+std::future<AsyncSudoku::SolveOutcome> AsyncSudoku::solve(
+		SudokuSolver::Settings const& settings,
+		Sudoku const& sudoku
+) {
+	auto task(makeTask<SolveOutcome>([settings, sudoku] {return runSolve(settings, sudoku);}));
+	std::future<SolveOutcome> outcome(task->get_future());
+	m_pool.submit([task] {(*task)();});
+	return outcome;
+}
+
+bool AsyncSudoku::trySolve(
+		SudokuSolver::Settings const& settings,
+		Sudoku const& sudoku,
+		std::future<SolveOutcome> & outcome
+) {
+	auto task(makeTask<SolveOutcome>([settings, sudoku] {return runSolve(settings, sudoku);}));
+	std::future<SolveOutcome> future(task->get_future());
+	if(!m_pool.trySubmit([task] {(*task)();}))
+		return false;
+	outcome = std::move(future);
+	return true;
+}
+
+bool AsyncSudoku::trySolve(
+		SudokuSolver::Settings const& settings,
+		Sudoku const& sudoku,
+		SolveCallback callback
+) {
+	auto task(makeTask<SolveOutcome>([settings, sudoku] {return runSolve(settings, sudoku);}));
+	return m_pool.trySubmit(withCallback(task, std::move(callback)));
+}
+
+std::future<AsyncSudoku::GenerateOutcome> AsyncSudoku::generate(
+		SudokuGenerator::Settings const& settings,
+		Sudoku const& sudoku
+) {
+	auto task(makeTask<GenerateOutcome>([settings, sudoku] {return runGenerate(settings, sudoku);}));
+	std::future<GenerateOutcome> outcome(task->get_future());
+	m_pool.submit([task] {(*task)();});
+	return outcome;
+}
+
+bool AsyncSudoku::tryGenerate(
+		SudokuGenerator::Settings const& settings,
+		Sudoku const& sudoku,
+		std::future<GenerateOutcome> & outcome
+) {
+	auto task(makeTask<GenerateOutcome>([settings, sudoku] {return runGenerate(settings, sudoku);}));
+	std::future<GenerateOutcome> future(task->get_future());
+	if(!m_pool.trySubmit([task] {(*task)();}))
+		return false;
+	outcome = std::move(future);
+	return true;
+}
+
+bool AsyncSudoku::tryGenerate(
+		SudokuGenerator::Settings const& settings,
+		Sudoku const& sudoku,
+		GenerateCallback callback
+) {
+	auto task(makeTask<GenerateOutcome>([settings, sudoku] {return runGenerate(settings, sudoku);}));
+	return m_pool.trySubmit(withCallback(task, std::move(callback)));
+}
+
+AsyncSudoku::SolveOutcome AsyncSudoku::runSolve(
+		SudokuSolver::Settings const& settings,
+		Sudoku const& sudoku
+) {
+	SudokuSolver solver(settings, sudoku);
+	SolveOutcome outcome;
+	outcome.result = solver.solve();
+	outcome.solutions = solver.getSolved();
+	outcome.stats = solver.getStats();
+	return outcome;
+}
+
+AsyncSudoku::GenerateOutcome AsyncSudoku::runGenerate(
+		SudokuGenerator::Settings const& settings,
+		Sudoku const& sudoku
+) {
+	SudokuGenerator generator(settings, Sudoku(sudoku));
+	GenerateOutcome outcome;
+	outcome.success = generator.generate();
+	outcome.sudoku = generator.sudoku();
+	outcome.solution = generator.getSolution();
+	outcome.nbAttempts = generator.nbAttempts();
+	return outcome;
+}
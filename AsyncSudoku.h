@@ -0,0 +1,90 @@
+#ifndef ASYNCSUDOKU_H_
+#define ASYNCSUDOKU_H_
+
+#include "SudokuSolver.h"
+#include "SudokuGenerator.h"
+#include "ThreadPool.h"
+#include <functional>
+#include <future>
+
+/**
+ * Runs SudokuSolver::solve and SudokuGenerator::generate on an internal
+ * ThreadPool. Every request returns a future, or calls a callback on the
+ * worker thread with the ready future when it is done. Errors are
+ * rethrown by future::get().
+ *
+ * The blocking variants wait while the queue is full. The try variants
+ * never block, they return false instead, so that an event loop can
+ * shed or defer the load. Use maxMicroseconds and maxNodes in the
+ * solver settings to bound the time a single request holds a worker.
+ */
+class AsyncSudoku {
+
+public:
+
+	struct SolveOutcome {
+		SudokuSolver::Result result;
+		SudokuSolver::ResultList solutions;
+		SolverStats stats;
+	};
+
+	struct GenerateOutcome {
+		bool success;
+		Sudoku sudoku;
+		Sudoku solution;
+		size_t nbAttempts;
+	};
+
+	typedef std::function<void(std::future<SolveOutcome>)> SolveCallback;
+	typedef std::function<void(std::future<GenerateOutcome>)> GenerateCallback;
+
+	/** see ThreadPool::ThreadPool */
+	AsyncSudoku(size_t nbThreads=0, size_t maxQueueDepth=1024);
+
+	std::future<SolveOutcome> solve(
+			SudokuSolver::Settings const& settings,
+			Sudoku const& sudoku);
+
+	bool trySolve(
+			SudokuSolver::Settings const& settings,
+			Sudoku const& sudoku,
+			std::future<SolveOutcome> & outcome);
+
+	/** The callback must not throw */
+	bool trySolve(
+			SudokuSolver::Settings const& settings,
+			Sudoku const& sudoku,
+			SolveCallback callback);
+
+	std::future<GenerateOutcome> generate(
+			SudokuGenerator::Settings const& settings,
+			Sudoku const& sudoku);
+
+	bool tryGenerate(
+			SudokuGenerator::Settings const& settings,
+			Sudoku const& sudoku,
+			std::future<GenerateOutcome> & outcome);
+
+	/** The callback must not throw */
+	bool tryGenerate(
+			SudokuGenerator::Settings const& settings,
+			Sudoku const& sudoku,
+			GenerateCallback callback);
+
+	/** Queue depth, running and completed requests of the pool */
+	ThreadPool::Metrics metrics() const {return m_pool.metrics();}
+
+private:
+
+	static SolveOutcome runSolve(
+			SudokuSolver::Settings const& settings,
+			Sudoku const& sudoku);
+
+	static GenerateOutcome runGenerate(
+			SudokuGenerator::Settings const& settings,
+			Sudoku const& sudoku);
+
+	ThreadPool m_pool;
+};
+
+#endif /* ASYNCSUDOKU_H_ */
@@ -0,0 +1,28 @@
+#ifndef CANCELLATIONTOKEN_H_
+#define CANCELLATIONTOKEN_H_
+
+#include <atomic>
+
+/**
+ * A flag to stop a running solve from another thread. The solver only
+ * reads it at its check points (each node and each iteration), so
+ * cancel() takes effect within one iteration and costs the solver no
+ * more than a relaxed atomic load.
+ */
+class CancellationToken {
+
+public:
+
+	void cancel() {m_cancelled.store(true, std::memory_order_relaxed);}
+
+	/** Allows the token to be used for another solve */
+	void reset() {m_cancelled.store(false, std::memory_order_relaxed);}
+
+	bool cancelled() const {return m_cancelled.load(std::memory_order_relaxed);}
+
+private:
+
+	std::atomic<bool> m_cancelled{false};
+};
+
+#endif /* CANCELLATIONTOKEN_H_ */
@@ -0,0 +1,71 @@
+#include "FixedSudoku.h"
+
+template class FixedSudoku<4,2>;
+template class FixedSudoku<6,3>;
+template class FixedSudoku<6,2>;
+template class FixedSudoku<9,3>;
+template class FixedSudoku<12,4>;
+template class FixedSudoku<12,3>;
+template class FixedSudoku<16,4>;
+template class FixedSudoku<25,5>;
+
+namespace {
+
+template <size_t Side, size_t BlockWidth>
+size_t countSolutions(Sudoku const& sudoku, size_t limit, Sudoku* firstSolution)
+{
+	FixedSudoku<Side,BlockWidth> board;
+	if(!board.load(sudoku))
+		return 0;
+	FixedSudoku<Side,BlockWidth> solution;
+	size_t nbSolutions(board.countSolutions(limit, &solution));
+	if(nbSolutions>0 && firstSolution) {
+		*firstSolution = sudoku;
+		solution.store(*firstSolution);
+	}
+	return nbSolutions;
+}
+
+struct FixedDispatch {
+	size_t sideLength;
+	size_t blockWidth;
+	size_t (*countSolutions)(Sudoku const&, size_t, Sudoku*);
+};
+
+FixedDispatch const dispatchTable[] = {
+	{ 4, 2, &countSolutions<4,2>},
+	{ 6, 3, &countSolutions<6,3>},
+	{ 6, 2, &countSolutions<6,2>},
+	{ 9, 3, &countSolutions<9,3>},
+	{12, 4, &countSolutions<12,4>},
+	{12, 3, &countSolutions<12,3>},
+	{16, 4, &countSolutions<16,4>},
+	{25, 5, &countSolutions<25,5>}
+};
+
+FixedDispatch const* findDispatch(size_t sideLength, size_t blockWidth) {
+	for(auto const& entry : dispatchTable)
+		if(entry.sideLength==sideLength && entry.blockWidth==blockWidth)
+			return &entry;
+	return nullptr;
+}
+
+} // namespace
+
+bool hasFixedGeometry(size_t sideLength, size_t blockWidth)
+{
+	return findDispatch(sideLength, blockWidth)!=nullptr;
+}
+
+size_t countSolutionsFixed(
+		Sudoku const& sudoku,
+		size_t limit,
+		Sudoku* firstSolution
+) {
+	FixedDispatch const* entry(findDispatch(sudoku.sideLength(), sudoku.blockWidth()));
+	if(!entry)
+		throw std::runtime_error("countSolutionsFixed: no specialization for "
+				+std::to_string(sudoku.sideLength())+"x"+std::to_string(sudoku.sideLength())
+				+" with block width "+std::to_string(sudoku.blockWidth()));
+	return entry->countSolutions(sudoku, limit, firstSolution);
+}
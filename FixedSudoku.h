@@ -0,0 +1,317 @@
+#ifndef FIXEDSUDOKU_H_
+#define FIXEDSUDOKU_H_
+
+#include "Sudoku.h"
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Compile-time geometry of a (Side x Side) Sudoku with blocks of
+ * BlockWidth x (Side/BlockWidth) fields. Field indices are column-major
+ * and blocks are enumerated column by column, just like in Sudoku and
+ * SudokuSolver. All tables are computed by the compiler.
+ */
+template <size_t Side, size_t BlockWidth>
+struct FixedGeometry {
+
+	static_assert(Side%BlockWidth==0, "block width must be a divisor of the side length");
+	static_assert(BlockWidth>1 && BlockWidth<Side, "blocks must not degenerate to rows or columns");
+
+	static constexpr size_t sideLength = Side;
+	static constexpr size_t blockWidth = BlockWidth;
+	static constexpr size_t blockHeight = Side/BlockWidth;
+	static constexpr size_t nbBlockRows = Side/blockHeight;
+	static constexpr size_t nbFields = Side*Side;
+	static constexpr size_t nbHouses = 3*Side;
+	/*! every field sees its row, column and block except for itself */
+	static constexpr size_t nbPeers = 2*(Side-1) + (Side-BlockWidth-blockHeight+1);
+
+	/*! index: house (rows, then columns, then blocks), value: fields */
+	typedef std::array<std::array<uint16_t, Side>, nbHouses> HouseTable;
+	/*! index: field, value: all fields sharing a house with it */
+	typedef std::array<std::array<uint16_t, nbPeers>, nbFields> PeerTable;
+
+	static constexpr size_t row(size_t fieldIndex) {return fieldIndex%Side;}
+	static constexpr size_t column(size_t fieldIndex) {return fieldIndex/Side;}
+	static constexpr size_t block(size_t fieldIndex) {
+		return (column(fieldIndex)/BlockWidth)*nbBlockRows + row(fieldIndex)/blockHeight;
+	}
+
+	static constexpr bool arePeers(size_t f1, size_t f2) {
+		return f1!=f2 && (
+				row(f1)==row(f2) ||
+				column(f1)==column(f2) ||
+				block(f1)==block(f2));
+	}
+
+	static constexpr HouseTable makeHouses() {
+		HouseTable houses{};
+		std::array<size_t, nbHouses> filled{};
+		for(size_t f=0; f<nbFields; ++f) {
+			size_t const h[3] = {row(f), Side+column(f), 2*Side+block(f)};
+			for(size_t k=0; k<3; ++k)
+				houses[h[k]][filled[h[k]]++] = static_cast<uint16_t>(f);
+		}
+		return houses;
+	}
+
+	static constexpr PeerTable makePeers() {
+		PeerTable peers{};
+		for(size_t f1=0; f1<nbFields; ++f1) {
+			size_t n=0;
+			for(size_t f2=0; f2<nbFields; ++f2)
+				if(arePeers(f1,f2))
+					peers[f1][n++] = static_cast<uint16_t>(f2);
+		}
+		return peers;
+	}
+
+	static constexpr HouseTable houses = makeHouses();
+	static constexpr PeerTable peers = makePeers();
+};
+
+/**
+ * A Sudoku engine specialized for one board geometry. Index math and
+ * peer lookups are resolved at compile time and candidates are stored
+ * as fixed-size masks, so the propagation loops have constant trip counts.
+ * Only naked and hidden singles plus backtracking are implemented, which
+ * makes it suitable for counting solutions but not for rating puzzles.
+ */
+template <size_t Side, size_t BlockWidth>
+class FixedSudoku {
+
+public:
+
+	static_assert(Side<=32, "candidate masks are limited to 32 numbers");
+
+	typedef FixedGeometry<Side, BlockWidth> Geometry;
+
+	/*! Bit (i-1) is set if the number i is still a candidate */
+	typedef typename std::conditional<(Side<=16), uint16_t, uint32_t>::type Mask;
+
+	static constexpr Mask allCandidates = static_cast<Mask>((uint64_t(1) << Side) - 1);
+
+	/*! Creates an empty board where every number is a candidate */
+	FixedSudoku();
+
+	/**
+	 * Copies the entries of a Sudoku with the same geometry.
+	 * Returns false if the entries contradict each other.
+	 */
+	bool load(Sudoku const& sudoku);
+
+	/** Enters all solutions of this board into a Sudoku with the same geometry */
+	void store(Sudoku & sudoku) const;
+
+	/**
+	 * Enters a number into a field and removes it from the candidates
+	 * of all peers. Returns false if it is not a candidate.
+	 */
+	bool place(size_t fieldIndex, size_t number);
+
+	/**
+	 * Applies naked and hidden singles until nothing changes.
+	 * Returns false if the board turned out to be contradictory.
+	 */
+	bool propagate();
+
+	/**
+	 * Counts the solutions of the board, but stops as soon as limit
+	 * solutions have been found. The first solution is copied to
+	 * firstSolution if given.
+	 */
+	size_t countSolutions(size_t limit, FixedSudoku* firstSolution=nullptr) const;
+
+	size_t nbSolved() const {return m_nbSolved;}
+
+	bool isSolved() const {return m_nbSolved==Geometry::nbFields;}
+
+	size_t getSolution(size_t fieldIndex) const {return m_solution[fieldIndex];}
+
+	Mask candidates(size_t fieldIndex) const {return m_candidates[fieldIndex];}
+
+private:
+
+	static constexpr Mask bit(size_t number) {
+		return static_cast<Mask>(Mask(1) << (number-1));
+	}
+
+	static size_t lowestNumber(Mask mask) {
+		return static_cast<size_t>(__builtin_ctz(mask))+1;
+	}
+
+	static size_t popCount(Mask mask) {
+		return static_cast<size_t>(__builtin_popcount(mask));
+	}
+
+	void search(size_t limit, size_t& nbSolutions, FixedSudoku* firstSolution);
+
+	std::array<Mask, Geometry::nbFields> m_candidates;
+	std::array<uint8_t, Geometry::nbFields> m_solution;
+	size_t m_nbSolved;
+};
+
+template <size_t Side, size_t BlockWidth>
+FixedSudoku<Side,BlockWidth>::FixedSudoku() :
+	m_nbSolved(0)
+{
+	m_candidates.fill(allCandidates);
+	m_solution.fill(0);
+}
+
+template <size_t Side, size_t BlockWidth>
+bool FixedSudoku<Side,BlockWidth>::load(Sudoku const& sudoku)
+{
+	if(sudoku.sideLength()!=Side || sudoku.blockWidth()!=BlockWidth)
+		throw std::runtime_error("FixedSudoku::load: geometry mismatch");
+	*this = FixedSudoku();
+	for(size_t f=0; f<Geometry::nbFields; ++f) {
+		if(!sudoku.isSolved(f)) continue;
+		if(!place(f, sudoku.getSolution(f)))
+			return false;
+	}
+	return true;
+}
+
+template <size_t Side, size_t BlockWidth>
+void FixedSudoku<Side,BlockWidth>::store(Sudoku & sudoku) const
+{
+	for(size_t f=0; f<Geometry::nbFields; ++f)
+		if(m_solution[f]!=0 && !sudoku.isSolved(f))
+			sudoku.enterSolution(f, m_solution[f]);
+}
+
+template <size_t Side, size_t BlockWidth>
+bool FixedSudoku<Side,BlockWidth>::place(size_t fieldIndex, size_t number)
+{
+	if(!(m_candidates[fieldIndex] & bit(number)))
+		return false;
+	Mask const keep = static_cast<Mask>(~bit(number));
+	for(auto peer : Geometry::peers[fieldIndex])
+		m_candidates[peer] &= keep;
+	m_candidates[fieldIndex] = 0;
+	m_solution[fieldIndex] = static_cast<uint8_t>(number);
+	++m_nbSolved;
+	return true;
+}
+
+template <size_t Side, size_t BlockWidth>
+bool FixedSudoku<Side,BlockWidth>::propagate()
+{
+	bool changed(true);
+	while(changed && !isSolved()) {
+		changed=false;
+
+		// naked singles
+		for(size_t f=0; f<Geometry::nbFields; ++f) {
+			if(m_solution[f]!=0) continue;
+			Mask const m(m_candidates[f]);
+			if(m==0) return false;
+			if((m & (m-1))==0) {
+				place(f, lowestNumber(m));
+				changed=true;
+			}
+		}
+
+		// hidden singles
+		for(auto const& house : Geometry::houses) {
+			Mask once(0), twice(0), solved(0);
+			for(auto f : house) {
+				if(m_solution[f]!=0) {
+					solved |= bit(m_solution[f]);
+				} else {
+					twice |= once & m_candidates[f];
+					once |= m_candidates[f];
+				}
+			}
+			if((once|solved)!=allCandidates) return false;
+			for(Mask single(once & ~twice); single; single &= single-1) {
+				size_t const number(lowestNumber(single));
+				for(auto f : house) {
+					if(m_candidates[f] & bit(number)) {
+						place(f, number);
+						changed=true;
+						break;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+template <size_t Side, size_t BlockWidth>
+size_t FixedSudoku<Side,BlockWidth>::countSolutions(
+		size_t limit,
+		FixedSudoku* firstSolution
+) const {
+	size_t nbSolutions(0);
+	if(limit==0) return 0;
+	FixedSudoku state(*this);
+	state.search(limit, nbSolutions, firstSolution);
+	return nbSolutions;
+}
+
+template <size_t Side, size_t BlockWidth>
+void FixedSudoku<Side,BlockWidth>::search(
+		size_t limit,
+		size_t& nbSolutions,
+		FixedSudoku* firstSolution
+) {
+	if(!propagate()) return;
+	if(isSolved()) {
+		if(nbSolutions==0 && firstSolution)
+			*firstSolution = *this;
+		++nbSolutions;
+		return;
+	}
+
+	// branch on the field with the fewest candidates
+	size_t fieldIndex(Geometry::nbFields);
+	size_t minPossible(Side+1);
+	for(size_t f=0; f<Geometry::nbFields; ++f) {
+		if(m_solution[f]!=0) continue;
+		size_t const n(popCount(m_candidates[f]));
+		if(n<minPossible) {
+			minPossible=n;
+			fieldIndex=f;
+			if(n==2) break;
+		}
+	}
+
+	for(Mask m(m_candidates[fieldIndex]); m; m &= m-1) {
+		FixedSudoku child(*this);
+		child.place(fieldIndex, lowestNumber(m));
+		child.search(limit, nbSolutions, firstSolution);
+		if(nbSolutions>=limit) return;
+	}
+}
+
+extern template class FixedSudoku<4,2>;
+extern template class FixedSudoku<6,3>;
+extern template class FixedSudoku<6,2>;
+extern template class FixedSudoku<9,3>;
+extern template class FixedSudoku<12,4>;
+extern template class FixedSudoku<12,3>;
+extern template class FixedSudoku<16,4>;
+extern template class FixedSudoku<25,5>;
+
+/**
+ * Returns true if there is a FixedSudoku specialization
+ * for the given side length and block width.
+ */
+bool hasFixedGeometry(size_t sideLength, size_t blockWidth);
+
+/**
+ * Counts the solutions of a Sudoku with the FixedSudoku specialization
+ * matching its geometry, stopping at limit. The first solution is written
+ * to firstSolution if given. Throws if there is no specialization for
+ * the geometry (see hasFixedGeometry).
+ */
+size_t countSolutionsFixed(
+		Sudoku const& sudoku,
+		size_t limit,
+		Sudoku* firstSolution=nullptr);
+
+#endif /* FIXEDSUDOKU_H_ */
@@ -0,0 +1,103 @@
+#include "LinkGraph.h"
+#include <algorithm>
+#include <limits>
+
+void LinkGraph::reserve(Sudoku const& sudoku)
+{
+	size_t nbFields(sudoku.nbFields());
+	m_strong.resize(sudoku.sideLength());
+	for(auto & adjacency : m_strong) {
+		adjacency.offsets.reserve(nbFields+1);
+		// at most one strong link per house
+		adjacency.neighbours.reserve(2*sudoku.nbHouses());
+	}
+	m_versions.reserve(sudoku.sideLength());
+	m_bivalueFields.reserve(nbFields);
+	m_bivalue.offsets.reserve(nbFields+1);
+	// each field has less than 3*sideLength peers
+	m_bivalue.neighbours.reserve(nbFields*3*sudoku.sideLength());
+}
+
+void LinkGraph::invalidate()
+{
+	std::fill(m_versions.begin(), m_versions.end(), std::numeric_limits<size_t>::max());
+}
+
+void LinkGraph::update(Sudoku const& sudoku)
+{
+	size_t sideLength(sudoku.sideLength());
+	if(sideLength!=m_sideLength) {
+		// different geometry: everything needs to be rebuilt
+		m_sideLength=sideLength;
+		m_strong.resize(sideLength);
+		m_versions.assign(sideLength, std::numeric_limits<size_t>::max());
+	}
+
+	bool changed(false);
+	for(size_t number(1); number<=sideLength; ++number) {
+		if(m_versions[number-1]==sudoku.numberVersion(number)) continue;
+		updateStrongLinks(sudoku, number);
+		m_versions[number-1]=sudoku.numberVersion(number);
+		changed=true;
+	}
+	if(changed)
+		updateBivalueFields(sudoku);
+}
+
+void LinkGraph::updateStrongLinks(Sudoku const& sudoku, size_t number)
+{
+	Adjacency & adjacency(m_strong[number-1]);
+	size_t nbFields(sudoku.nbFields());
+
+	// first pass: count the links of each field, second pass: store them
+	adjacency.offsets.assign(nbFields+1, 0);
+	for(size_t pass(0); pass<2; ++pass) {
+		for(size_t house(0); house<sudoku.nbHouses(); ++house) {
+			Sudoku::CandidateMask positions(sudoku.candidatePositions(house, number));
+			if(popCount(positions)!=2) continue;
+			size_t field1(sudoku.houseField(house, lowestBit(positions)));
+			positions &= positions-1;
+			size_t field2(sudoku.houseField(house, lowestBit(positions)));
+			if(pass==0) {
+				++adjacency.offsets[field1+1];
+				++adjacency.offsets[field2+1];
+			} else {
+				adjacency.neighbours[adjacency.offsets[field1]++]=field2;
+				adjacency.neighbours[adjacency.offsets[field2]++]=field1;
+			}
+		}
+		if(pass==0) {
+			for(size_t f(0); f<nbFields; ++f)
+				adjacency.offsets[f+1] += adjacency.offsets[f];
+			adjacency.neighbours.resize(adjacency.offsets[nbFields]);
+		}
+	}
+	// the second pass moved every offset to the start of the next field
+	for(size_t f(nbFields); f>0; --f)
+		adjacency.offsets[f]=adjacency.offsets[f-1];
+	adjacency.offsets[0]=0;
+}
+
+void LinkGraph::updateBivalueFields(Sudoku const& sudoku)
+{
+	size_t nbFields(sudoku.nbFields());
+	m_bivalueFields.clear();
+	for(size_t f(0); f<nbFields; ++f)
+		if(sudoku.nbCandidates(f)==2)
+			m_bivalueFields.push_back(f);
+
+	m_bivalue.offsets.assign(nbFields+1, 0);
+	m_bivalue.neighbours.clear();
+	size_t next(0);
+	for(size_t f(0); f<nbFields; ++f) {
+		m_bivalue.offsets[f]=m_bivalue.neighbours.size();
+		if(next==m_bivalueFields.size() || m_bivalueFields[next]!=f) continue;
+		++next;
+		for(auto other : m_bivalueFields) {
+			if(!sudoku.arePeers(f, other)) continue;
+			if(!(sudoku.candidateMask(f) & sudoku.candidateMask(other))) continue;
+			m_bivalue.neighbours.push_back(other);
+		}
+	}
+	m_bivalue.offsets[nbFields]=m_bivalue.neighbours.size();
+}
@@ -0,0 +1,96 @@
+#ifndef LINKGRAPH_H_
+#define LINKGRAPH_H_
+
+#include "Sudoku.h"
+#include <vector>
+
+/**
+ * Links between the candidates of a Sudoku as needed by coloring and
+ * chain techniques:
+ * - strong link: a number is possible in exactly two fields of a house,
+ *   so one of the two fields must contain it
+ * - bivalue field: a field with exactly two candidates, i.e. a strong
+ *   link between two numbers within the same field
+ * Fields sharing a house are weakly linked for their common candidates,
+ * which is cheap to test (Sudoku::arePeers) and therefore not stored.
+ *
+ * All adjacency is stored in flat arrays (offsets per field into one
+ * list of neighbours), so rebuilding reuses the existing capacity.
+ * The graph is updated incrementally: only the numbers whose candidates
+ * changed since the last update (see Sudoku::numberVersion) are rebuilt.
+ */
+class LinkGraph {
+
+public:
+
+	/** A range of field indices */
+	struct Neighbours {
+		size_t const* first;
+		size_t const* last;
+		size_t const* begin() const {return first;}
+		size_t const* end() const {return last;}
+		size_t size() const {return static_cast<size_t>(last-first);}
+	};
+
+	/**
+	 * Reserves the storage for the largest possible graph of the geometry
+	 * of the sudoku, so that update does not need to allocate
+	 */
+	void reserve(Sudoku const& sudoku);
+
+	/** Forces the next update to rebuild the whole graph, e.g. for another sudoku */
+	void invalidate();
+
+	/** Brings the graph up to date with the candidates of the sudoku */
+	void update(Sudoku const& sudoku);
+
+	/** All fields that are strongly linked to a field for a number */
+	Neighbours strongLinks(size_t number, size_t fieldIndex) const {
+		return neighbours(m_strong[number-1], fieldIndex);
+	}
+
+	/** The number of strong links of a number */
+	size_t nbStrongLinks(size_t number) const {
+		return m_strong[number-1].neighbours.size()/2;
+	}
+
+	/** All fields with exactly two candidates */
+	Sudoku::FieldGroup const& bivalueFields() const {return m_bivalueFields;}
+
+	/** All bivalue fields sharing a house and at least one
+	 * candidate with the bivalue field fieldIndex */
+	Neighbours bivalueNeighbours(size_t fieldIndex) const {
+		return neighbours(m_bivalue, fieldIndex);
+	}
+
+private:
+
+	// compressed adjacency: the neighbours of field f are
+	// neighbours[offsets[f]] .. neighbours[offsets[f+1]-1]
+	struct Adjacency {
+		std::vector<size_t> offsets;
+		std::vector<size_t> neighbours;
+	};
+
+	static Neighbours neighbours(Adjacency const& adjacency, size_t fieldIndex) {
+		size_t const* data(adjacency.neighbours.data());
+		return Neighbours{
+			data+adjacency.offsets[fieldIndex],
+			data+adjacency.offsets[fieldIndex+1]};
+	}
+
+	void updateStrongLinks(Sudoku const& sudoku, size_t number);
+
+	void updateBivalueFields(Sudoku const& sudoku);
+
+	// index: number-1
+	std::vector<Adjacency> m_strong;
+	Adjacency m_bivalue;
+	Sudoku::FieldGroup m_bivalueFields;
+
+	// index: number-1, the version of the number at the last update
+	std::vector<size_t> m_versions;
+	size_t m_sideLength = 0;
+};
+
+#endif /* LINKGRAPH_H_ */
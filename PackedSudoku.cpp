@@ -0,0 +1,175 @@
+#include "PackedSudoku.h"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+char const magic[4] = {'S', 'D', 'K', 'P'};
+
+void checkGeometry(size_t sideLength, size_t blockWidth) {
+	if(sideLength<2 || sideLength>Sudoku::maxSideLength)
+		throw std::runtime_error("packed sudokus: invalid side length "+std::to_string(sideLength));
+	if(blockWidth<2 || sideLength%blockWidth!=0 || blockWidth==sideLength)
+		throw std::runtime_error("packed sudokus: invalid block width "+std::to_string(blockWidth));
+}
+
+} // namespace
+
+size_t PackedFormat::bitsPerCell(size_t sideLength) {
+	size_t bits(1);
+	while((size_t(1) << bits) <= sideLength)
+		++bits;
+	return bits;
+}
+
+size_t PackedFormat::recordSize(size_t sideLength) {
+	return (sideLength*sideLength*bitsPerCell(sideLength)+7)/8;
+}
+
+void PackedFormat::writeHeader(char* header, size_t sideLength, size_t blockWidth) {
+	checkGeometry(sideLength, blockWidth);
+	std::memset(header, 0, headerSize);
+	std::memcpy(header, magic, 4);
+	header[4] = static_cast<char>(version & 0xff);
+	header[5] = static_cast<char>(version >> 8);
+	header[6] = static_cast<char>(sideLength);
+	header[7] = static_cast<char>(blockWidth);
+	header[8] = static_cast<char>(bitsPerCell(sideLength));
+}
+
+void PackedFormat::packRecord(Sudoku const& sudoku, char* record) {
+	size_t bits(bitsPerCell(sudoku.sideLength()));
+	std::memset(record, 0, recordSize(sudoku.sideLength()));
+	for(size_t f(0); f<sudoku.nbFields(); ++f) {
+		size_t bit(f*bits);
+		unsigned value(sudoku.getSolution(f) << bit%8);
+		record[bit/8] = static_cast<char>(record[bit/8] | (value & 0xff));
+		if(bit%8+bits>8)
+			record[bit/8+1] = static_cast<char>(record[bit/8+1] | (value >> 8));
+	}
+}
+
+PackedSudokuWriter::PackedSudokuWriter(
+		std::string const& fileName,
+		size_t sideLength,
+		size_t blockWidth
+) :
+		m_file(fileName, std::ios::binary | std::ios::trunc),
+		m_fileName(fileName),
+		m_sideLength(sideLength),
+		m_blockWidth(blockWidth),
+		m_record(PackedFormat::recordSize(sideLength), '\0')
+{
+	char header[PackedFormat::headerSize];
+	PackedFormat::writeHeader(header, sideLength, blockWidth);
+	if(!m_file)
+		throw std::runtime_error("could not open "+fileName);
+	m_file.write(header, sizeof(header));
+}
+
+void PackedSudokuWriter::write(Sudoku const& sudoku)
+{
+	if(sudoku.sideLength()!=m_sideLength || sudoku.blockWidth()!=m_blockWidth)
+		throw std::runtime_error("PackedSudokuWriter: the geometry of the sudoku differs from "+m_fileName);
+	PackedFormat::packRecord(sudoku, &m_record[0]);
+	m_file.write(m_record.data(), m_record.size());
+	++m_nbWritten;
+}
+
+void PackedSudokuWriter::close()
+{
+	m_file.close();
+	if(!m_file)
+		throw std::runtime_error("could not write "+m_fileName);
+}
+
+PackedSudokuReader::PackedSudokuReader(std::string const& fileName)
+{
+	int fd(open(fileName.c_str(), O_RDONLY));
+	if(fd<0)
+		throw std::runtime_error("could not open "+fileName);
+	struct stat info;
+	if(fstat(fd, &info)<0) {
+		::close(fd);
+		throw std::runtime_error("could not stat "+fileName);
+	}
+	m_mapSize=info.st_size;
+	if(m_mapSize<PackedFormat::headerSize) {
+		::close(fd);
+		throw std::runtime_error(fileName+" is not a packed sudoku file");
+	}
+	m_map=mmap(nullptr, m_mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(m_map==MAP_FAILED) {
+		m_map=nullptr;
+		throw std::runtime_error("could not map "+fileName);
+	}
+	madvise(m_map, m_mapSize, MADV_SEQUENTIAL);
+	m_data=static_cast<uint8_t const*>(m_map);
+	try {
+		parseHeader(m_mapSize);
+	} catch(...) {
+		munmap(m_map, m_mapSize);
+		throw;
+	}
+}
+
+PackedSudokuReader::PackedSudokuReader(void const* data, size_t size) :
+		m_data(static_cast<uint8_t const*>(data))
+{
+	if(size<PackedFormat::headerSize)
+		throw std::runtime_error("not a packed sudoku file");
+	parseHeader(size);
+}
+
+PackedSudokuReader::~PackedSudokuReader()
+{
+	if(m_map)
+		munmap(m_map, m_mapSize);
+}
+
+void PackedSudokuReader::parseHeader(size_t size)
+{
+	if(std::memcmp(m_data, magic, 4)!=0)
+		throw std::runtime_error("not a packed sudoku file");
+	uint16_t version(m_data[4] | (m_data[5] << 8));
+	if(version!=PackedFormat::version)
+		throw std::runtime_error("unsupported packed sudoku version "+std::to_string(version));
+	m_sideLength=m_data[6];
+	m_blockWidth=m_data[7];
+	checkGeometry(m_sideLength, m_blockWidth);
+	m_bitsPerCell=m_data[8];
+	if(m_bitsPerCell!=PackedFormat::bitsPerCell(m_sideLength))
+		throw std::runtime_error("packed sudokus: invalid bits per cell");
+	m_recordSize=PackedFormat::recordSize(m_sideLength);
+	if((size-PackedFormat::headerSize)%m_recordSize!=0)
+		throw std::runtime_error("packed sudokus: truncated record");
+	m_nbRecords=(size-PackedFormat::headerSize)/m_recordSize;
+	m_records=m_data+PackedFormat::headerSize;
+	m_empty=Sudoku(m_sideLength, m_blockWidth);
+}
+
+void PackedSudokuReader::load(size_t record, Sudoku & sudoku) const
+{
+	if(record>=m_nbRecords)
+		throw std::runtime_error("PackedSudokuReader: record "+std::to_string(record)+" out of range");
+	if(sudoku.sideLength()!=m_sideLength || sudoku.blockWidth()!=m_blockWidth)
+		sudoku=m_empty;
+	size_t conflict(sudoku.loadGivens([this, record](size_t fieldIndex) {
+		return cell(record, fieldIndex);
+	}));
+	if(conflict<sudoku.nbFields())
+		throw std::runtime_error("PackedSudokuReader: record "+std::to_string(record)
+				+" has conflicting givens in field "+std::to_string(conflict));
+}
+
+Sudoku PackedSudokuReader::operator[](size_t record) const
+{
+	Sudoku sudoku;
+	load(record, sudoku);
+	return sudoku;
+}
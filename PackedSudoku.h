@@ -0,0 +1,138 @@
+#ifndef PACKEDSUDOKU_H_
+#define PACKEDSUDOKU_H_
+
+#include "Sudoku.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/*
+ * A compact binary format for large collections of sudokus of one
+ * geometry. The file starts with a 16 byte header:
+ *
+ *   bytes 0-3   magic "SDKP"
+ *   bytes 4-5   format version (little endian), currently 1
+ *   byte  6     side length
+ *   byte  7     block width
+ *   byte  8     bits per cell, the bits needed for the side length
+ *   bytes 9-15  zero
+ *
+ * followed by fixed-size records, one per sudoku. A record stores the
+ * cells in field index order (see Sudoku::xyToIndex), each with the given
+ * number or 0, packed little endian into bitsPerCell bits and padded to
+ * whole bytes: 41 bytes for a 9x9 sudoku. The number of records follows
+ * from the file size.
+ */
+namespace PackedFormat {
+
+static constexpr size_t headerSize = 16;
+static constexpr uint16_t version = 1;
+
+/** The bits needed to store the numbers 0..sideLength */
+size_t bitsPerCell(size_t sideLength);
+
+/** The bytes of one record */
+size_t recordSize(size_t sideLength);
+
+/** Writes the headerSize bytes of the header, throws for invalid geometries */
+void writeHeader(char* header, size_t sideLength, size_t blockWidth);
+
+/** Packs the numbers of a sudoku into the recordSize bytes of record */
+void packRecord(Sudoku const& sudoku, char* record);
+
+}
+
+/** Appends sudokus to a packed file */
+class PackedSudokuWriter {
+
+public:
+
+	/** Creates the file and writes the header */
+	PackedSudokuWriter(
+			std::string const& fileName,
+			size_t sideLength,
+			size_t blockWidth);
+
+	/** Throws if the geometry differs from the one of the file */
+	void write(Sudoku const& sudoku);
+
+	/** Flushes the file, throws if anything could not be written */
+	void close();
+
+	size_t nbWritten() const {return m_nbWritten;}
+
+private:
+	std::ofstream m_file;
+	std::string m_fileName;
+	size_t m_sideLength;
+	size_t m_blockWidth;
+	std::string m_record;
+	size_t m_nbWritten = 0;
+};
+
+/**
+ * Reads a packed file through a read-only memory map, or a packed
+ * buffer in memory. Nothing is parsed or copied up front: the records
+ * are decoded when accessed.
+ */
+class PackedSudokuReader {
+
+public:
+
+	/** Maps the file, throws if it is not a valid packed file */
+	explicit PackedSudokuReader(std::string const& fileName);
+
+	/** Reads a packed file image that stays owned by the caller */
+	PackedSudokuReader(void const* data, size_t size);
+
+	~PackedSudokuReader();
+
+	PackedSudokuReader(PackedSudokuReader const&) = delete;
+	PackedSudokuReader& operator=(PackedSudokuReader const&) = delete;
+
+	size_t size() const {return m_nbRecords;}
+
+	size_t sideLength() const {return m_sideLength;}
+
+	size_t blockWidth() const {return m_blockWidth;}
+
+	/** The number in a field of a record, 0 if it is empty */
+	size_t cell(size_t record, size_t fieldIndex) const {
+		size_t bit(fieldIndex*m_bitsPerCell);
+		uint8_t const* bytes(m_records+record*m_recordSize+bit/8);
+		// a cell spans at most two bytes
+		unsigned value(bytes[0]);
+		if(bit%8+m_bitsPerCell>8)
+			value |= unsigned(bytes[1]) << 8;
+		return (value >> bit%8) & ((1u << m_bitsPerCell)-1);
+	}
+
+	/**
+	 * Fills sudoku with the givens of a record. A sudoku of the file's
+	 * geometry keeps its storage, so loading many records into the same
+	 * sudoku does not allocate.
+	 */
+	void load(size_t record, Sudoku & sudoku) const;
+
+	Sudoku operator[](size_t record) const;
+
+private:
+
+	void parseHeader(size_t size);
+
+	uint8_t const* m_data = nullptr;
+	uint8_t const* m_records = nullptr;
+	// the mapping, if the file was mapped
+	void* m_map = nullptr;
+	size_t m_mapSize = 0;
+	size_t m_sideLength = 0;
+	size_t m_blockWidth = 0;
+	size_t m_bitsPerCell = 0;
+	size_t m_recordSize = 0;
+	size_t m_nbRecords = 0;
+	// an empty sudoku of the file's geometry, assigned before loading
+	// into a sudoku of another geometry
+	Sudoku m_empty;
+};
+
+#endif /* PACKEDSUDOKU_H_ */
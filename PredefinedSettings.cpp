@@ -16,11 +16,29 @@ SudokuSolver::Settings SudokuSolver::Settings::easy(
 		false, // allowBlockBlock
 		false, // allowNakedTuples
 		false, // allowHiddenTuples
-		false, // nextIterOnChange
+		false, // allowFish
+		false, // allowSimpleColoring
+		false, // allowXYWing
+		false, // allowXYChain
+		true,  // nextIterOnChange
 		GuessMode::Deterministic,
 		0, // maxTupleSize
+		0, // maxFishSize
+		6, // maxXYChainLength
+		std::numeric_limits<size_t>::max(), // maxColoringSteps
+		std::numeric_limits<size_t>::max(), // maxXYWingSteps
+		std::numeric_limits<size_t>::max(), // maxXYChainSteps
 		0, // maxNbGuesses
-		std::numeric_limits<size_t>::max() // maxResults
+		std::numeric_limits<size_t>::max(), // maxResults
+		std::numeric_limits<size_t>::max(), // maxSearchMemory
+		std::numeric_limits<size_t>::max(), // maxNodes
+		std::numeric_limits<size_t>::max(), // maxMicroseconds
+		0, // randomSeed
+		0, // restartBacktracks
+		Branching::FewestCandidates,
+		false, // leastConstrainingValue
+		false, // allowProbing
+		64 // maxProbes
 );
 
 SudokuSolver::Settings SudokuSolver::Settings::medium(
@@ -30,11 +48,29 @@ SudokuSolver::Settings SudokuSolver::Settings::medium(
 		true,  // allowBlockBlock
 		true,  // allowNakedTuples
 		true,  // allowHiddenTuples
-		false, // nextIterOnChange
+		false, // allowFish
+		false, // allowSimpleColoring
+		false, // allowXYWing
+		false, // allowXYChain
+		true,  // nextIterOnChange
 		GuessMode::Deterministic,
 		2, // maxTupleSize
+		0, // maxFishSize
+		6, // maxXYChainLength
+		std::numeric_limits<size_t>::max(), // maxColoringSteps
+		std::numeric_limits<size_t>::max(), // maxXYWingSteps
+		std::numeric_limits<size_t>::max(), // maxXYChainSteps
 		0, // maxNbGuesses
-		std::numeric_limits<size_t>::max() // maxResults
+		std::numeric_limits<size_t>::max(), // maxResults
+		std::numeric_limits<size_t>::max(), // maxSearchMemory
+		std::numeric_limits<size_t>::max(), // maxNodes
+		std::numeric_limits<size_t>::max(), // maxMicroseconds
+		0, // randomSeed
+		0, // restartBacktracks
+		Branching::FewestCandidates,
+		false, // leastConstrainingValue
+		false, // allowProbing
+		64 // maxProbes
 );
 
 SudokuSolver::Settings SudokuSolver::Settings::hard(
@@ -44,11 +80,29 @@ SudokuSolver::Settings SudokuSolver::Settings::hard(
 		true,  // allowBlockBlock
 		true,  // allowNakedTuples
 		true,  // allowHiddenTuples
-		false, // nextIterOnChange
+		true,  // allowFish
+		true,  // allowSimpleColoring
+		true,  // allowXYWing
+		false, // allowXYChain
+		true,  // nextIterOnChange
 		GuessMode::Deterministic,
 		4, // maxTupleSize
+		2, // maxFishSize
+		6, // maxXYChainLength
+		std::numeric_limits<size_t>::max(), // maxColoringSteps
+		std::numeric_limits<size_t>::max(), // maxXYWingSteps
+		std::numeric_limits<size_t>::max(), // maxXYChainSteps
 		0, // maxNbGuesses
-		std::numeric_limits<size_t>::max() // maxResults
+		std::numeric_limits<size_t>::max(), // maxResults
+		std::numeric_limits<size_t>::max(), // maxSearchMemory
+		std::numeric_limits<size_t>::max(), // maxNodes
+		std::numeric_limits<size_t>::max(), // maxMicroseconds
+		0, // randomSeed
+		0, // restartBacktracks
+		Branching::FewestCandidates,
+		false, // leastConstrainingValue
+		false, // allowProbing
+		64 // maxProbes
 );
 
 SudokuSolver::Settings SudokuSolver::Settings::extreme(
@@ -58,29 +112,59 @@ SudokuSolver::Settings SudokuSolver::Settings::extreme(
 		true,  // allowBlockBlock
 		true,  // allowNakedTuples
 		true,  // allowHiddenTuples
-		false, // nextIterOnChange
+		true,  // allowFish
+		true,  // allowSimpleColoring
+		true,  // allowXYWing
+		true,  // allowXYChain
+		true,  // nextIterOnChange
 		GuessMode::Deterministic,
 		4, // maxTupleSize
+		4, // maxFishSize
+		8, // maxXYChainLength
+		std::numeric_limits<size_t>::max(), // maxColoringSteps
+		std::numeric_limits<size_t>::max(), // maxXYWingSteps
+		std::numeric_limits<size_t>::max(), // maxXYChainSteps
 		1, // maxNbGuesses
-		std::numeric_limits<size_t>::max() // maxResults
+		std::numeric_limits<size_t>::max(), // maxResults
+		std::numeric_limits<size_t>::max(), // maxSearchMemory
+		std::numeric_limits<size_t>::max(), // maxNodes
+		std::numeric_limits<size_t>::max(), // maxMicroseconds
+		0, // randomSeed
+		0, // restartBacktracks
+		Branching::FewestCandidates,
+		false, // leastConstrainingValue
+		false, // allowProbing
+		64 // maxProbes
 );
 
 SudokuGenerator::Settings SudokuGenerator::Settings::easy(
 		SudokuSolver::Settings::easy,
-		0.4f, 0.5f, 0
+		0.4f, 0.5f, 0,
+		std::numeric_limits<size_t>::max(), // maxAttempts
+		std::numeric_limits<size_t>::max(), // maxGenerationMicroseconds
+		true // printProgress
 );
 
 SudokuGenerator::Settings SudokuGenerator::Settings::medium(
 		SudokuSolver::Settings::medium,
-		0.3f, 0.4f, 0
+		0.3f, 0.4f, 0,
+		std::numeric_limits<size_t>::max(), // maxAttempts
+		std::numeric_limits<size_t>::max(), // maxGenerationMicroseconds
+		true // printProgress
 );
 
 SudokuGenerator::Settings SudokuGenerator::Settings::hard(
 		SudokuSolver::Settings::hard,
-		0.3f, 0.4f, 1
+		0.3f, 0.4f, 1,
+		std::numeric_limits<size_t>::max(), // maxAttempts
+		std::numeric_limits<size_t>::max(), // maxGenerationMicroseconds
+		true // printProgress
 );
 
 SudokuGenerator::Settings SudokuGenerator::Settings::extreme(
 		SudokuSolver::Settings::extreme,
-		0.1f, 0.3f, 1
+		0.1f, 0.3f, 1,
+		std::numeric_limits<size_t>::max(), // maxAttempts
+		std::numeric_limits<size_t>::max(), // maxGenerationMicroseconds
+		true // printProgress
 );
@@ -0,0 +1,78 @@
+#ifndef RANDOMENGINE_H_
+#define RANDOMENGINE_H_
+
+#include <cstdint>
+#include <limits>
+#include <random>
+
+/**
+ * A small and fast pseudo random number generator (xoshiro256**) for the
+ * scrambler, the generator and random guessing. It satisfies the standard
+ * UniformRandomBitGenerator requirements, so it works with std::shuffle
+ * and the std distributions.
+ *
+ * Seeds are expanded into the 256 bit state with splitmix64, so any seed,
+ * including small consecutive ones, gives a well mixed state. Unlike
+ * std::random_device, seeding costs no system call.
+ */
+class RandomEngine {
+
+public:
+
+	typedef uint64_t result_type;
+
+	explicit RandomEngine(uint64_t seed = 0) {reseed(seed);}
+
+	void reseed(uint64_t seed) {
+		for(auto & word : m_state) {
+			// splitmix64
+			seed += 0x9e3779b97f4a7c15;
+			uint64_t z(seed);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			word = z ^ (z >> 31);
+		}
+	}
+
+	static constexpr result_type min() {return 0;}
+
+	static constexpr result_type max() {return std::numeric_limits<result_type>::max();}
+
+	result_type operator()() {
+		uint64_t result(rotl(m_state[1]*5, 7)*9);
+		uint64_t t(m_state[1] << 17);
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = rotl(m_state[3], 45);
+		return result;
+	}
+
+	/**
+	 * The engine of the calling thread. It is seeded from
+	 * std::random_device once per thread and then used to seed the
+	 * engines of the objects created on that thread.
+	 */
+	static RandomEngine& threadEngine() {
+		thread_local RandomEngine engine(
+				(uint64_t(std::random_device()()) << 32) | std::random_device()());
+		return engine;
+	}
+
+	/** seed itself if it is not 0 (a reproducible run), else a fresh seed */
+	static uint64_t makeSeed(uint64_t seed) {
+		return seed!=0 ? seed : threadEngine()();
+	}
+
+private:
+
+	static uint64_t rotl(uint64_t x, int k) {
+		return (x << k) | (x >> (64-k));
+	}
+
+	uint64_t m_state[4];
+};
+
+#endif /* RANDOMENGINE_H_ */
@@ -0,0 +1,165 @@
+#include "Socket.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+struct Address {
+	bool isUnix;
+	std::string path; // unix
+	std::string host; // tcp
+	std::string port; // tcp
+};
+
+Address parseAddress(std::string const& address) {
+	Address result{false, "", "127.0.0.1", ""};
+	if(address.compare(0, 5, "unix:")==0) {
+		result.isUnix=true;
+		result.path=address.substr(5);
+		if(result.path.empty() || result.path.size()>=sizeof(sockaddr_un::sun_path))
+			throw std::runtime_error("invalid unix socket path in "+address);
+		return result;
+	}
+	if(address.compare(0, 4, "tcp:")!=0)
+		throw std::runtime_error("address must start with unix: or tcp: "+address);
+	std::string rest(address.substr(4));
+	size_t colon(rest.rfind(':'));
+	if(colon==std::string::npos)
+		result.port=rest;
+	else {
+		result.host=rest.substr(0, colon);
+		result.port=rest.substr(colon+1);
+	}
+	if(result.port.empty())
+		throw std::runtime_error("missing port in "+address);
+	return result;
+}
+
+std::runtime_error systemError(std::string const& what) {
+	return std::runtime_error(what+": "+std::strerror(errno));
+}
+
+int unixSocket(Address const& address, bool server) {
+	int fd(socket(AF_UNIX, SOCK_STREAM, 0));
+	if(fd<0)
+		throw systemError("socket");
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family=AF_UNIX;
+	std::strncpy(addr.sun_path, address.path.c_str(), sizeof(addr.sun_path)-1);
+	sockaddr const* generic(reinterpret_cast<sockaddr const*>(&addr));
+	if(server) {
+		unlink(address.path.c_str());
+		if(bind(fd, generic, sizeof(addr))<0 || listen(fd, SOMAXCONN)<0) {
+			close(fd);
+			throw systemError("could not listen on "+address.path);
+		}
+	} else if(connect(fd, generic, sizeof(addr))<0) {
+		close(fd);
+		throw systemError("could not connect to "+address.path);
+	}
+	return fd;
+}
+
+int tcpSocket(Address const& address, bool server) {
+	addrinfo hints;
+	std::memset(&hints, 0, sizeof(hints));
+	hints.ai_family=AF_UNSPEC;
+	hints.ai_socktype=SOCK_STREAM;
+	addrinfo* list(nullptr);
+	int error(getaddrinfo(address.host.c_str(), address.port.c_str(), &hints, &list));
+	if(error!=0)
+		throw std::runtime_error(address.host+":"+address.port+": "+gai_strerror(error));
+	int fd(-1);
+	for(addrinfo* info(list); info && fd<0; info=info->ai_next) {
+		fd=socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+		if(fd<0) continue;
+		bool success;
+		if(server) {
+			int yes(1);
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+			success = bind(fd, info->ai_addr, info->ai_addrlen)==0 && listen(fd, SOMAXCONN)==0;
+		} else
+			success = connect(fd, info->ai_addr, info->ai_addrlen)==0;
+		if(!success) {
+			close(fd);
+			fd=-1;
+		}
+	}
+	freeaddrinfo(list);
+	if(fd<0)
+		throw systemError(std::string(server ? "could not listen on " : "could not connect to ")
+				+address.host+":"+address.port);
+	return fd;
+}
+
+} // namespace
+
+int listenOn(std::string const& address) {
+	Address parsed(parseAddress(address));
+	return parsed.isUnix ? unixSocket(parsed, true) : tcpSocket(parsed, true);
+}
+
+int acceptConnection(int listener) {
+	while(true) {
+		int fd(accept(listener, nullptr, nullptr));
+		if(fd>=0 || (errno!=EINTR && errno!=ECONNABORTED))
+			return fd;
+	}
+}
+
+int connectTo(std::string const& address) {
+	Address parsed(parseAddress(address));
+	return parsed.isUnix ? unixSocket(parsed, false) : tcpSocket(parsed, false);
+}
+
+bool writeAll(int fd, std::string const& data) {
+	size_t written(0);
+	while(written<data.size()) {
+		ssize_t n(send(fd, data.data()+written, data.size()-written, MSG_NOSIGNAL));
+		if(n<0 && errno==EINTR) continue;
+		if(n<=0) return false;
+		written+=n;
+	}
+	return true;
+}
+
+void closeSocket(int fd) {
+	close(fd);
+}
+
+void shutdownSocket(int fd) {
+	shutdown(fd, SHUT_RDWR);
+}
+
+bool LineReader::readLine(std::string & line) {
+	while(true) {
+		size_t end(m_buffer.find('\n', m_begin));
+		if(end!=std::string::npos) {
+			line.assign(m_buffer, m_begin, end-m_begin);
+			if(!line.empty() && line.back()=='\r')
+				line.pop_back();
+			m_begin=end+1;
+			return true;
+		}
+		// keep only the incomplete line
+		m_buffer.erase(0, m_begin);
+		m_begin=0;
+		char chunk[4096];
+		ssize_t n(recv(m_fd, chunk, sizeof(chunk), 0));
+		if(n<0 && errno==EINTR) continue;
+		if(n<=0) {
+			// a last line without newline
+			if(m_buffer.empty()) return false;
+			line.swap(m_buffer);
+			m_buffer.clear();
+			return true;
+		}
+		m_buffer.append(chunk, n);
+	}
+}
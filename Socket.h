@@ -0,0 +1,46 @@
+#ifndef SOCKET_H_
+#define SOCKET_H_
+
+#include <cstddef>
+#include <string>
+
+/*
+ * Minimal POSIX socket helpers for SudokuServer and its load test.
+ * Addresses are either "unix:<path>", "tcp:<host>:<port>" or
+ * "tcp:<port>" (localhost). Errors throw std::runtime_error.
+ */
+
+/** A listening socket bound to the address, unix socket files are replaced */
+int listenOn(std::string const& address);
+
+/** The next connection of a listening socket, -1 on failure */
+int acceptConnection(int listener);
+
+/** A socket connected to the address */
+int connectTo(std::string const& address);
+
+/** Writes the whole string, returns false if the peer is gone */
+bool writeAll(int fd, std::string const& data);
+
+void closeSocket(int fd);
+
+/** Ends pending reads and accepts on the socket without closing it */
+void shutdownSocket(int fd);
+
+/** Reads a socket line by line through a buffer */
+class LineReader {
+
+public:
+
+	explicit LineReader(int fd) : m_fd(fd) {}
+
+	/** The next line without the newline, false at the end of the stream */
+	bool readLine(std::string & line);
+
+private:
+	int m_fd;
+	std::string m_buffer;
+	size_t m_begin = 0;
+};
+
+#endif /* SOCKET_H_ */
@@ -0,0 +1,74 @@
+#include "SolverStats.h"
+#include <algorithm>
+
+char const* techniqueName(Technique technique)
+{
+	switch(technique) {
+	case Technique::nakedSingle: return "nakedSingle";
+	case Technique::hiddenSingle: return "hiddenSingle";
+	case Technique::interactions: return "interactions";
+	case Technique::tuples: return "tuples";
+	case Technique::fish: return "fish";
+	case Technique::simpleColoring: return "simpleColoring";
+	case Technique::xyWing: return "xyWing";
+	case Technique::xyChain: return "xyChain";
+	case Technique::probing: return "probing";
+	}
+	return "unknown";
+}
+
+std::ostream& operator << (std::ostream& os, Technique technique)
+{
+	os << techniqueName(technique);
+	return os;
+}
+
+void SolverStats::merge(SolverStats const& other)
+{
+	for(size_t i(0); i<nbTechniques; ++i) {
+		techniques[i].invocations += other.techniques[i].invocations;
+		techniques[i].eliminations += other.techniques[i].eliminations;
+		techniques[i].placements += other.techniques[i].placements;
+		techniques[i].nanoseconds += other.techniques[i].nanoseconds;
+	}
+	search.nodes += other.search.nodes;
+	search.backtracks += other.search.backtracks;
+	search.maxDepth = std::max(search.maxDepth, other.search.maxDepth);
+	search.boardCopies += other.search.boardCopies;
+	search.memoryCutoffs += other.search.memoryCutoffs;
+	search.restarts += other.search.restarts;
+	allocations += other.allocations;
+	iterationAllocations += other.iterationAllocations;
+}
+
+void SolverStats::printJson(std::ostream& os) const
+{
+	os << "{\n";
+	printJsonMembers(os);
+	os << "}\n";
+}
+
+void SolverStats::printJsonMembers(std::ostream& os) const
+{
+	os << "  \"techniques\": {\n";
+	for(size_t i(0); i<nbTechniques; ++i) {
+		TechniqueStats const& t(techniques[i]);
+		os << "    \"" << static_cast<Technique>(i) << "\": {"
+				<< "\"invocations\": " << t.invocations
+				<< ", \"eliminations\": " << t.eliminations
+				<< ", \"placements\": " << t.placements
+				<< ", \"nanoseconds\": " << t.nanoseconds
+				<< (i+1<nbTechniques ? "},\n" : "}\n");
+	}
+	os << "  },\n  \"search\": {"
+			<< "\"nodes\": " << search.nodes
+			<< ", \"backtracks\": " << search.backtracks
+			<< ", \"maxDepth\": " << search.maxDepth
+			<< ", \"boardCopies\": " << search.boardCopies
+			<< ", \"memoryCutoffs\": " << search.memoryCutoffs
+			<< ", \"restarts\": " << search.restarts
+			<< "},\n  \"allocations\": {"
+			<< "\"solve\": " << allocations
+			<< ", \"iterations\": " << iterationAllocations
+			<< "}\n";
+}
@@ -0,0 +1,88 @@
+#ifndef SOLVERSTATS_H_
+#define SOLVERSTATS_H_
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+/** The solving techniques of the SudokuSolver, as counted in SolverStats */
+enum class Technique : char {
+	nakedSingle,
+	hiddenSingle,
+	interactions,
+	tuples,
+	fish,
+	simpleColoring,
+	xyWing,
+	xyChain,
+	probing
+};
+
+static constexpr size_t nbTechniques = 9;
+
+char const* techniqueName(Technique technique);
+
+std::ostream& operator << (std::ostream& os, Technique technique);
+
+/**
+ * Counters of the SudokuSolver: what each technique did and how much
+ * time it took, and the shape of the search tree spanned by guessing.
+ * The stats of several solves can be added up with merge.
+ */
+struct SolverStats {
+
+	struct TechniqueStats {
+		size_t invocations = 0;
+		/*! candidates removed, including those removed by placements */
+		size_t eliminations = 0;
+		/*! solutions entered */
+		size_t placements = 0;
+		uint64_t nanoseconds = 0;
+	};
+
+	struct SearchStats {
+		/*! boards that were propagated, the given one included */
+		size_t nodes = 0;
+		/*! guesses that ended without a solution */
+		size_t backtracks = 0;
+		/*! the maximum number of nested guesses */
+		size_t maxDepth = 0;
+		/*! boards copied onto or back from the search stack */
+		size_t boardCopies = 0;
+		/*! guesses not made because of maxSearchMemory */
+		size_t memoryCutoffs = 0;
+		/*! random restarts, see restartBacktracks */
+		size_t restarts = 0;
+	};
+
+	TechniqueStats& operator[](Technique technique) {
+		return techniques[static_cast<size_t>(technique)];
+	}
+
+	TechniqueStats const& operator[](Technique technique) const {
+		return techniques[static_cast<size_t>(technique)];
+	}
+
+	/** adds the counters of another solve, e.g. of a split frontier */
+	void merge(SolverStats const& other);
+
+	/** writes all counters as a JSON object */
+	void printJson(std::ostream& os) const;
+
+	/** the members of printJson without the braces, to extend the object */
+	void printJsonMembers(std::ostream& os) const;
+
+	// index: Technique
+	std::array<TechniqueStats, nbTechniques> techniques;
+	SearchStats search;
+
+	/*! heap allocations during solve(), only counted if built with
+	 * SUDOKU_COUNT_ALLOCATIONS */
+	size_t allocations = 0;
+	/*! heap allocations within the propagation loop of all nodes,
+	 * which should stay 0 (see AllocationCounter) */
+	size_t iterationAllocations = 0;
+};
+
+#endif /* SOLVERSTATS_H_ */
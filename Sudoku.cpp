@@ -1,8 +1,7 @@
 #include "Sudoku.h"
+#include "SudokuWriter.h"
 #include <math.h>
 #include <algorithm>
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
 
 Sudoku::Sudoku() :
 	m_sideLength(0),
@@ -11,24 +10,30 @@ Sudoku::Sudoku() :
 	m_nbBlockRows(0),
 	m_nbBlockColumns(0),
 	m_nbSolved(0),
-	m_nbGuesses(0) {}
+	m_nbGuesses(0),
+	m_version(0),
+	m_nbCandidates(0) {}
 
 Sudoku::Sudoku(size_t length) :
 	m_sideLength(length),
 	m_nbSolved(0),
 	m_nbGuesses(0),
 	m_possible(length*length),
+	m_positions(3*length*length),
+	m_numberVersions(length),
+	m_version(0),
+	m_nbCandidates(0),
 	m_solution(length*length)
 {
+	if(length>maxSideLength)
+		throw std::runtime_error("side length "+std::to_string(length)+" exceeds the maximum of "+std::to_string(maxSideLength));
 	nearSquareFactors(length, m_blockHeight, m_blockWidth);
 	if(m_blockHeight==1)
 		throw std::runtime_error("invalid block size"+std::to_string(m_blockWidth)+"x"+std::to_string(m_blockHeight));
 	m_nbBlockRows = m_sideLength/m_blockHeight;
 	m_nbBlockColumns = m_sideLength/m_blockWidth;
-	for(size_t i=0; i<m_possible.size(); ++i) {
-		m_possible[i].resize(length);
-		m_possible[i].set();
-	}
+	std::fill(m_possible.begin(), m_possible.end(), allCandidates());
+	updatePositions();
 }
 
 Sudoku::Sudoku(size_t length, size_t blockWidth) :
@@ -38,88 +43,42 @@ Sudoku::Sudoku(size_t length, size_t blockWidth) :
 	m_nbSolved(0),
 	m_nbGuesses(0),
 	m_possible(length*length),
+	m_positions(3*length*length),
+	m_numberVersions(length),
+	m_version(0),
+	m_nbCandidates(0),
 	m_solution(length*length)
 {
 	if(length%blockWidth!=0)
 		throw std::runtime_error("length "+std::to_string(m_sideLength)+" cannot be factorized with "+std::to_string(m_blockWidth));
 	if(length==blockWidth || blockWidth==1)
 		throw std::runtime_error("invalid block size"+std::to_string(m_blockWidth)+"x"+std::to_string(m_blockHeight));
+	if(length>maxSideLength)
+		throw std::runtime_error("side length "+std::to_string(length)+" exceeds the maximum of "+std::to_string(maxSideLength));
 	m_nbBlockRows = m_sideLength/m_blockHeight;
 	m_nbBlockColumns = m_sideLength/m_blockWidth;
-	for(size_t i=0; i<m_possible.size(); ++i) {
-		m_possible[i].resize(length);
-		m_possible[i].set();
-	}
+	std::fill(m_possible.begin(), m_possible.end(), allCandidates());
+	updatePositions();
 }
 
 void Sudoku::getCandidates(size_t fieldIndex, std::vector<size_t>& numbers) {
-	numbers.resize(m_possible[fieldIndex].count());
+	numbers.resize(nbCandidates(fieldIndex));
 	size_t idx=0;
-	for(size_t i=1; i<=m_sideLength; ++i)
-		if(isCandidate(fieldIndex,i))
-			numbers[idx++]=i;
-	if(idx!=numbers.size())
-		throw std::runtime_error("idx="+std::to_string(idx)+" != size="+std::to_string(numbers.size()));
+	for(CandidateMask m=m_possible[fieldIndex]; m; m &= m-1)
+		numbers[idx++]=lowestBit(m)+1;
 }
 
 void Sudoku::print() const
 {
-	GridPoint p;
-	for(p.y=0; p.y<m_sideLength; ++p.y)  {
-		if(p.y % m_blockHeight == 0)
-			printFrameLine();
-		for(p.x=0; p.x<m_sideLength; ++p.x) {
-			if(p.x % m_blockWidth == 0)
-				std::cout << "|";
-			std::cout << std::setw(4);
-			size_t s=m_solution[xyToIndex(p)];
-			if(s>0)
-				std::cout << s;
-			else
-				std::cout << '?';
-		}
-		std::cout << "|" << std::endl;
-	}
-	printFrameLine();
-}
-
-void Sudoku::printFrameLine() const {
-	int blockw(static_cast<int>(m_blockWidth)*4);
-	std::cout << std::setfill('-');
-	for(size_t i(0); i<m_nbBlockColumns; i++)
-		std::cout << "+" << std::setw(blockw) << "";
-	std::cout << std::setfill(' ') << "+" << std::endl;
-}
-
-void Sudoku::printFrameLine2(size_t fieldWidth) const {
-	std::cout << std::setfill('-');
-	for(size_t i(0); i<m_sideLength; i++)
-		std::cout << "+" << std::setw(fieldWidth) << "";
-	std::cout << std::setfill(' ') << "+" << std::endl;
+	SudokuWriter writer;
+	writer.appendFramed(*this);
+	writer.flush(std::cout);
 }
 
 void Sudoku::printCandidates() const {
-	size_t fieldWidth(3);
-	GridPoint p;
-	for(p.y=0; p.y<m_sideLength; ++p.y)  {
-		printFrameLine2(m_blockWidth*fieldWidth);
-		for(size_t y(0); y<m_blockHeight; y++) {
-			size_t number(y*m_blockHeight);
-			for(p.x=0; p.x<m_sideLength; ++p.x) {
-				std::cout << "|";
-				for(size_t x(0); x<m_blockWidth; x++) {
-					size_t fieldIndex(xyToIndex(p));
-					if(m_solution[fieldIndex]==0 && m_possible[fieldIndex][number])
-						std::cout << std::setw(fieldWidth) << number+1;
-					else
-						std::cout << std::setw(fieldWidth) << "";
-					number = y*m_blockHeight + (number+1) % m_blockHeight;
-				}
-			}
-			std::cout << "|" << std::endl;
-		}
-	}
-	printFrameLine2(m_blockWidth*fieldWidth);
+	SudokuWriter writer;
+	writer.appendCandidates(*this);
+	writer.flush(std::cout);
 }
 
 void Sudoku::printCandidates(size_t number, size_t indent) const
@@ -130,7 +89,7 @@ void Sudoku::printCandidates(size_t number, size_t indent) const
 		if(indent>0)
 			std::cout << std::setw(indent) << "";
 		for(p.x=0; p.x<m_sideLength; ++p.x) {
-			std::cout << " " << m_possible[xyToIndex(p)][number];
+			std::cout << " " << isCandidate(xyToIndex(p),number+1);
 		}
 		std::cout << std::endl;
 	}
@@ -159,24 +118,18 @@ void Sudoku::enterSolution(size_t fieldIndex, size_t number, bool guessed)
 		for(auto c : cands) std::cout << " " << c;
 		std::cout <<std::endl;
 		printCandidates(number);
-		std::cout << m_possible[fieldIndex].to_string() << std::endl;
 		throw std::runtime_error("Sudoku::enterSolution: Invalid number "
 				+ std::to_string(number)+" for field "+std::to_string(fieldIndex));
 	}
 
-	FieldGroup group(m_sideLength);
-	getRow(fieldIndex,group);
-	for(auto field : group)
-		makeImpossible(field,number);
-	getColumn(fieldIndex,group);
-	for(auto field : group)
-		makeImpossible(field,number);
-	getBlock(fieldIndex,group);
-	for(auto field : group)
-		makeImpossible(field,number);
+	// only the fields where the number is still a candidate are affected
+	for(auto house : housesOf(fieldIndex))
+		for(CandidateMask p(candidatePositions(house,number)); p; p &= p-1)
+			makeImpossible(houseField(house,lowestBit(p)),number);
 
+	if(m_trail) save(fieldIndex);
 	m_solution[fieldIndex]=number;
-	m_possible[fieldIndex].reset();
+	setCandidates(fieldIndex,0);
 	++m_nbSolved;
 	if(guessed)
 		++m_nbGuesses;
@@ -187,34 +140,59 @@ void Sudoku::clearSolution(size_t fieldIndex)
 	if(!isSolved(fieldIndex)) return;
 
 	size_t number=getSolution(fieldIndex);
+	if(m_trail) save(fieldIndex);
 	m_solution[fieldIndex]=0;
 
 	// set all numbers to possible in the field where the solution was removed
 	// will be reduced by clearSolutionHelper
-	m_possible[fieldIndex].set();
+	setCandidates(fieldIndex,allCandidates());
 
-	FieldGroup group(m_sideLength);
 	// since fields are treated twice it might be more efficient to first merge the
-	// groups, but the operation in the clearSolutionHelper is quite trivial.
-	getRow(fieldIndex,group);
-	clearSolutionHelper(fieldIndex, number, group);
-	getColumn(fieldIndex,group);
-	clearSolutionHelper(fieldIndex, number, group);
-	getBlock(fieldIndex,group);
-	clearSolutionHelper(fieldIndex, number, group);
+	// houses, but the operation in the clearSolutionHelper is quite trivial.
+	for(auto house : housesOf(fieldIndex))
+		clearSolutionHelper(fieldIndex, number, house);
 	m_nbSolved--;
 }
 
-void Sudoku::clearSolutionHelper(size_t fieldIndex, size_t number, FieldGroup const& group) {
-	for(auto field : group) {
+void Sudoku::clearSolutionHelper(size_t fieldIndex, size_t number, size_t house) {
+	for(size_t k(0); k<m_sideLength; ++k) {
+		size_t field(houseField(house,k));
 		if(isSolved(field)) {
 			makeImpossible(fieldIndex,getSolution(field));
-		} else {
+		} else if(checkPossible(field,number)) {
+			// the number may still be blocked by another house of the field
 			makePossible(field,number);
 		}
 	}
 }
 
+void Sudoku::setTrail(Trail* trail) {
+	m_trail=trail;
+	if(!trail) return;
+	trail->entries.clear();
+	// at most one entry per field, so recording does not allocate
+	trail->entries.reserve(nbFields());
+	trail->saved.resize(nbFields(), 0);
+	++trail->recording;
+}
+
+void Sudoku::undoTrail() {
+	Trail* trail(m_trail);
+	m_trail=nullptr;
+	for(auto const& entry : trail->entries) {
+		size_t& solution(m_solution[entry.fieldIndex]);
+		if(solution!=entry.solution) {
+			if(solution==0)
+				++m_nbSolved;
+			else if(entry.solution==0)
+				--m_nbSolved;
+			solution=entry.solution;
+		}
+		setCandidates(entry.fieldIndex, entry.candidates);
+	}
+	setTrail(trail);
+}
+
 void Sudoku::trivialSolution() {
 	GridPoint p;
 	size_t n(0);
@@ -222,11 +200,12 @@ void Sudoku::trivialSolution() {
 		size_t blockY = p.y / m_blockHeight;
 		for(p.x=0; p.x<m_sideLength; ++p.x) {
 			size_t f=xyToIndex(p);
-			m_possible[f].reset();
+			m_possible[f]=0;
 			m_solution[f] = 1 + (n+m_blockWidth*p.y+blockY) % m_sideLength;
 			++n;
 		}
 	}
+	updatePositions();
 	m_nbSolved=nbFields();
 }
 
@@ -324,22 +303,10 @@ void Sudoku::getBlock(GridPoint p, FieldGroup& block) const
 bool Sudoku::checkPossible(size_t fieldIndex, size_t i) {
 	if(m_solution[fieldIndex]!=0 && m_solution[fieldIndex]!=i)
 		return false;
-	FieldGroup group(m_sideLength);
-	getRow(fieldIndex,group);
-	for(auto field : group)
-		if(m_solution[field]==i)
-			return false;
-
-	getColumn(fieldIndex,group);
-	for(auto field : group)
-		if(m_solution[field]==i)
-			return false;
-
-	getBlock(fieldIndex,group);
-	for(auto field : group)
-		if(m_solution[field]==i)
-			return false;
-
+	for(auto house : housesOf(fieldIndex))
+		for(size_t k(0); k<m_sideLength; ++k)
+			if(m_solution[houseField(house,k)]==i)
+				return false;
 	return true;
 }
 
@@ -459,12 +426,110 @@ void Sudoku::rotateLeft() {
 
 void Sudoku::swapFields(size_t fieldIndex1, size_t fieldIndex2) {
 	std::swap(m_solution[fieldIndex1],m_solution[fieldIndex2]);
-	std::swap(m_possible[fieldIndex1],m_possible[fieldIndex2]);
+	CandidateMask candidates1(m_possible[fieldIndex1]);
+	setCandidates(fieldIndex1, m_possible[fieldIndex2]);
+	setCandidates(fieldIndex2, candidates1);
 }
 
 void Sudoku::swapBlockOrientation() {
 	std::swap(m_blockHeight,m_blockWidth);
 	std::swap(m_nbBlockRows,m_nbBlockColumns);
+	// the blocks are different now
+	updatePositions();
+}
+
+void Sudoku::setPositions(size_t fieldIndex, CandidateMask numbers, bool possible) {
+	if(numbers==0) return;
+	if(possible)
+		m_nbCandidates += popCount(numbers);
+	else
+		m_nbCandidates -= popCount(numbers);
+	size_t x(fieldIndex/m_sideLength), y(fieldIndex-x*m_sideLength);
+	size_t bx(x/m_blockWidth), by(y/m_blockHeight);
+	size_t const offsets[3] = {
+			m_sideLength*rowHouse(y),
+			m_sideLength*columnHouse(x),
+			m_sideLength*blockHouse(bx*m_nbBlockRows+by)
+	};
+	CandidateMask const bits[3] = {
+			CandidateMask(1) << x,
+			CandidateMask(1) << y,
+			CandidateMask(1) << ((x-bx*m_blockWidth)*m_blockHeight + y-by*m_blockHeight)
+	};
+	for(; numbers; numbers &= numbers-1) {
+		size_t index(lowestBit(numbers));
+		++m_numberVersions[index];
+		++m_version;
+		for(size_t h(0); h<3; ++h) {
+			if(possible)
+				m_positions[offsets[h]+index] |= bits[h];
+			else
+				m_positions[offsets[h]+index] &= ~bits[h];
+		}
+	}
+}
+
+void Sudoku::updatePositions() {
+	std::fill(m_positions.begin(), m_positions.end(), 0);
+	m_nbCandidates=0;
+	size_t max(nbFields());
+	for(size_t fieldIndex(0); fieldIndex<max; fieldIndex++)
+		setPositions(fieldIndex, m_possible[fieldIndex], true);
+}
+
+size_t Sudoku::loadGivens(std::vector<size_t> const& numbers) {
+	if(numbers.size()!=nbFields())
+		throw std::runtime_error("Sudoku::loadGivens: expected "+std::to_string(nbFields())
+				+" numbers, got "+std::to_string(numbers.size()));
+	return loadGivens([&numbers](size_t fieldIndex) {return numbers[fieldIndex];});
+}
+
+size_t Sudoku::updateFromSolutions() {
+	size_t max(nbFields());
+	// the numbers used in each house
+	std::array<CandidateMask, 3*maxSideLength> used;
+	std::fill(used.begin(), used.begin()+nbHouses(), 0);
+	size_t conflict(max);
+	size_t invalid(0);
+	m_nbSolved=0;
+	for(size_t fieldIndex(0); fieldIndex<max; fieldIndex++) {
+		size_t number(m_solution[fieldIndex]);
+		if(number==0) continue;
+		if(number>m_sideLength) {
+			invalid=number;
+			conflict=fieldIndex;
+			break;
+		}
+		CandidateMask bit(CandidateMask(1) << (number-1));
+		auto houses(housesOf(fieldIndex));
+		if((used[houses[0]] | used[houses[1]] | used[houses[2]]) & bit) {
+			conflict=fieldIndex;
+			break;
+		}
+		for(auto house : houses)
+			used[house] |= bit;
+		++m_nbSolved;
+	}
+	if(conflict<max) {
+		std::fill(m_solution.begin(), m_solution.end(), 0);
+		std::fill(m_possible.begin(), m_possible.end(), allCandidates());
+		m_nbSolved=0;
+	} else {
+		for(size_t fieldIndex(0); fieldIndex<max; fieldIndex++) {
+			if(isSolved(fieldIndex)) {
+				m_possible[fieldIndex]=0;
+				continue;
+			}
+			auto houses(housesOf(fieldIndex));
+			m_possible[fieldIndex] = allCandidates()
+					& ~(used[houses[0]] | used[houses[1]] | used[houses[2]]);
+		}
+	}
+	updatePositions();
+	if(invalid>0)
+		throw std::runtime_error("Sudoku::loadGivens: Invalid number "
+				+std::to_string(invalid)+" for field "+std::to_string(conflict));
+	return conflict;
 }
 
 bool Sudoku::checkSanity() const {
@@ -518,7 +583,7 @@ bool Sudoku::sameBlock(GridPoint const& p1, GridPoint const& p2) {
 	return true;
 }
 
-bool Sudoku::operator==(Sudoku const& other) {
+bool Sudoku::operator==(Sudoku const& other) const {
 	if(m_sideLength != other.m_sideLength) return false;
 	if(m_blockWidth != other.m_blockWidth) return false;
 	// blockHeight, nbBlockRows and nbBlockColumns are dependent on the above
@@ -531,40 +596,6 @@ bool Sudoku::operator==(Sudoku const& other) {
 	return true;
 }
 
-std::istream &operator>>( std::istream  &input, Sudoku &sudoku )
-{
-	std::string line;
-	size_t size=0;
-	GridPoint p;
-	std::shared_ptr<Sudoku> tmp;
-	while(getline(input,line)) {
-		std::vector<std::string> parts;
-		boost::trim(line);
-		boost::split(parts,line, boost::is_any_of("\t "), boost::token_compress_on);
-
-		if(size!=parts.size()) {
-			if(size==0) {
-				size=parts.size();
-				tmp.reset(new Sudoku(size));
-			} else
-				throw std::runtime_error("number of elements is not the same on each line");
-		}
-		if(size==0)
-			throw std::runtime_error("empty sudoku");
-
-		for(p.x=0; p.x<size; ++p.x) {
-			if(parts[p.x]=="?") continue;
-			size_t nb = boost::lexical_cast<size_t>(parts[p.x]);
-			tmp->enterSolution(p, nb);
-		}
-
-		if(++p.y == size) break;
-	}
-
-	sudoku=*tmp;
-	return input;
-}
-
 void Sudoku::nearSquareFactors(size_t n, size_t& f1, size_t &f2)
 {
 	f1=sqrt(n);
@@ -573,18 +604,9 @@ void Sudoku::nearSquareFactors(size_t n, size_t& f1, size_t &f2)
 }
 
 std::ostream &operator<<( std::ostream  &output, Sudoku const& sudoku ) {
-	GridPoint p;
-	for(p.y=0; p.y<sudoku.m_sideLength; ++p.y)  {
-		for(p.x=0; p.x<sudoku.m_sideLength; ++p.x) {
-			output << std::setw(4);
-			size_t s=sudoku.m_solution[sudoku.xyToIndex(p)];
-			if(s>0)
-				output << s;
-			else
-				output << '?';
-		}
-		output << std::endl;
-	}
+	thread_local SudokuWriter writer;
+	writer.appendGrid(sudoku);
+	writer.flush(output);
 	return output;
 }
 
@@ -1,7 +1,9 @@
 #ifndef SUDOKU_H_
 #define SUDOKU_H_
 
-#include "DynamicBitset.h"
+#include "Utility.h"
+#include <array>
+#include <cstdint>
 #include <set>
 #include <iostream>
 #include <iomanip>
@@ -67,6 +69,12 @@ public:
 	/*! A field group may be a row, column or block */
 	typedef std::vector<size_t> FieldGroup;
 
+	/*! Bit (i-1) is set if the number i can still be entered */
+	typedef uint64_t CandidateMask;
+
+	/*! The largest side length for which the candidates fit into a CandidateMask */
+	static constexpr size_t maxSideLength = 64;
+
 	/*! Default constructor creates sudoku of size 0 */
 	Sudoku();
 
@@ -112,7 +120,7 @@ public:
 	 * Returns false if the field already has a number entered.
 	 */
 	bool isCandidate(size_t fieldIndex, size_t i) const {
-		return m_possible[fieldIndex][i-1];
+		return (m_possible[fieldIndex] >> (i-1)) & 1;
 	}
 
 	/*
@@ -128,7 +136,7 @@ public:
 	 * into a field. Returns 0 if the field already has a number entered.
 	 */
 	size_t nbCandidates(size_t fieldIndex) const {
-		return m_possible[fieldIndex].count();
+		return popCount(m_possible[fieldIndex]);
 	}
 
 	/*
@@ -139,6 +147,21 @@ public:
 		return nbCandidates(xyToIndex(p));
 	}
 
+	/*
+	 * Returns the numbers that could potentially still be entered
+	 * into a field as a bit mask. Returns 0 if the field already has
+	 * a number entered.
+	 */
+	CandidateMask candidateMask(size_t fieldIndex) const {
+		return m_possible[fieldIndex];
+	}
+
+	/* A mask with the bits of all numbers 1..sideLength set */
+	CandidateMask allCandidates() const {
+		return m_sideLength==maxSideLength ?
+				~CandidateMask(0) : (CandidateMask(1) << m_sideLength) - 1;
+	}
+
 	/* The number of fields that already contain a solution */
 	size_t nbSolved() const { return m_nbSolved; }
 
@@ -196,11 +219,11 @@ public:
 
 	/** Returns the number that has been entered into the field.
 	 * Returns zero for empty fields */
-	size_t getSolution(size_t fieldIndex) {return m_solution[fieldIndex];}
+	size_t getSolution(size_t fieldIndex) const {return m_solution[fieldIndex];}
 
 	/** Returns the number that has been entered into the field.
 	 * Returns zero for empty fields */
-	size_t getSolution(GridPoint const& p) {return getSolution(xyToIndex(p));}
+	size_t getSolution(GridPoint const& p) const {return getSolution(xyToIndex(p));}
 
 	/** Enter a number into a field. Throws if the number conflicts the rules */
 	void enterSolution(size_t fieldIndex, size_t number, bool guessed=false);
@@ -210,11 +233,46 @@ public:
 		enterSolution(xyToIndex(p),number, guessed);
 	}
 
+	/**
+	 * Replaces the content with the givens of a puzzle, given(fieldIndex)
+	 * being the number of each field or 0 if it is empty. Instead of
+	 * entering the numbers one by one, all numbers are written first and
+	 * the candidates of all fields are then computed in one pass from the
+	 * numbers used in each house. Keeps the geometry and the storage.
+	 * Returns nbFields() if the givens are consistent. Otherwise returns
+	 * the first field (in field index order) whose number is already used
+	 * in one of its houses, and the Sudoku is left empty.
+	 */
+	template<class Givens>
+	size_t loadGivens(Givens const& given) {
+		size_t max(nbFields());
+		for(size_t fieldIndex(0); fieldIndex<max; ++fieldIndex)
+			m_solution[fieldIndex]=given(fieldIndex);
+		m_nbGuesses=0;
+		return updateFromSolutions();
+	}
+
+	/** loadGivens with the numbers in field index order */
+	size_t loadGivens(std::vector<size_t> const& numbers);
+
 	/** Removes the number entered in a certain field and re-evaluates the
 	 * candidates for all numbers for affected fields (self, column, row, block) */
 	void clearSolution(size_t fieldIndex);
 
-	void clearSolutionHelper(size_t fieldIndex, size_t number, FieldGroup const& group);
+	void clearSolutionHelper(size_t fieldIndex, size_t number, size_t house);
+
+	/**
+	 * Removes the numbers entered in the fields [first, last). Unlike
+	 * calling clearSolution for each of them, the candidates of all fields
+	 * are re-evaluated only once, from the numbers left in each house.
+	 * Worth it when clearing more than a few fields.
+	 */
+	template<class FieldIterator>
+	void clearSolutions(FieldIterator first, FieldIterator last) {
+		for(; first!=last; ++first)
+			m_solution[*first]=0;
+		updateFromSolutions();
+	}
 
 	/** Removes the number entered in a certain field and re-evaluates the
 	 * candidates for all numbers for affected fields (self, column, row, block) */
@@ -225,6 +283,35 @@ public:
 	/** Replaces the content with a trivial Sudoku. */
 	void trivialSolution();
 
+	/**
+	 * The fields changed since recording started, with their previous
+	 * candidates and numbers, see setTrail.
+	 */
+	struct Trail {
+		struct Entry {
+			size_t fieldIndex;
+			CandidateMask candidates;
+			size_t solution;
+		};
+		std::vector<Entry> entries;
+		// index: field, the recording in which the field was saved
+		std::vector<size_t> saved;
+		size_t recording = 0;
+	};
+
+	/**
+	 * Starts recording the changes made by enterSolution, clearSolution
+	 * and the candidate updates into trail, so that undoTrail can take
+	 * them back. Each field is saved only before its first change, so
+	 * undoing costs as much as the fields that changed, not a copy of the
+	 * board. nullptr stops recording. Copies of the Sudoku share the
+	 * trail, so the board must not be copied while recording.
+	 */
+	void setTrail(Trail* trail);
+
+	/** Restores the state of the last setTrail or undoTrail */
+	void undoTrail();
+
 	/** get the field indices for all (un)solved fields */
 	void getSolvedOrUnsolvedFields(FieldGroup& group, bool solved=true) const;
 
@@ -240,6 +327,94 @@ public:
 			std::set<size_t>& missingNumbers
 	) const;
 
+	/**
+	 * The number of houses, i.e. rows, columns and blocks. Houses are
+	 * numbered rows first, then columns, then blocks. Blocks are numbered
+	 * column-major just like the fields.
+	 */
+	size_t nbHouses() const {return 3*m_sideLength;}
+
+	/** The house index of a row */
+	size_t rowHouse(size_t row) const {return row;}
+
+	/** The house index of a column */
+	size_t columnHouse(size_t column) const {return m_sideLength+column;}
+
+	/** The house index of a block */
+	size_t blockHouse(size_t block) const {return 2*m_sideLength+block;}
+
+	/** The row containing a field */
+	size_t rowOf(size_t fieldIndex) const {return fieldIndex%m_sideLength;}
+
+	/** The column containing a field */
+	size_t columnOf(size_t fieldIndex) const {return fieldIndex/m_sideLength;}
+
+	/** The block containing a field (blocks are numbered column-major) */
+	size_t blockOf(size_t fieldIndex) const {
+		return (columnOf(fieldIndex)/m_blockWidth)*m_nbBlockRows
+				+ rowOf(fieldIndex)/m_blockHeight;
+	}
+
+	/** The row, column and block house of a field */
+	std::array<size_t,3> housesOf(size_t fieldIndex) const {
+		return {{
+			rowHouse(rowOf(fieldIndex)),
+			columnHouse(columnOf(fieldIndex)),
+			blockHouse(blockOf(fieldIndex))}};
+	}
+
+	/** Check if two different fields share a row, column or block */
+	bool arePeers(size_t fieldIndex1, size_t fieldIndex2) const {
+		return fieldIndex1!=fieldIndex2 && (
+				rowOf(fieldIndex1)==rowOf(fieldIndex2) ||
+				columnOf(fieldIndex1)==columnOf(fieldIndex2) ||
+				blockOf(fieldIndex1)==blockOf(fieldIndex2));
+	}
+
+	/**
+	 * A counter that changes whenever the candidates of a number change
+	 * anywhere in the Sudoku. Allows derived data to be updated lazily.
+	 */
+	size_t numberVersion(size_t number) const {
+		return m_numberVersions[number-1];
+	}
+
+	/** A counter that changes whenever any candidate changes */
+	size_t version() const {return m_version;}
+
+	/** The number of candidates summed over all fields */
+	size_t totalCandidates() const {return m_nbCandidates;}
+
+	/** The bytes occupied by this Sudoku including its heap storage */
+	size_t memoryUsage() const {
+		return sizeof(Sudoku)
+				+ (m_possible.capacity()+m_positions.capacity())*sizeof(CandidateMask)
+				+ (m_numberVersions.capacity()+m_solution.capacity())*sizeof(size_t);
+	}
+
+	/**
+	 * Returns a mask of the positions k within a house (see houseField)
+	 * where a number is still a candidate. The masks are kept up to date
+	 * with every change of the candidates, so this is a plain lookup.
+	 */
+	CandidateMask candidatePositions(size_t house, size_t number) const {
+		return m_positions[house*m_sideLength+number-1];
+	}
+
+	/** Returns the index of the k-th field of a house without
+	 * building a FieldGroup. Fields are in the same order as in getRow,
+	 * getColumn and getBlock. */
+	size_t houseField(size_t house, size_t k) const {
+		if(house<m_sideLength) // row
+			return k*m_sideLength + house;
+		house -= m_sideLength;
+		if(house<m_sideLength) // column
+			return house*m_sideLength + k;
+		house -= m_sideLength;
+		return (m_blockWidth*(house/m_nbBlockRows) + k/m_blockHeight)*m_sideLength
+				+ m_blockHeight*(house%m_nbBlockRows) + k%m_blockHeight;
+	}
+
 	/** get the field indices for a row */
 	void getRow(size_t fieldIndex, FieldGroup& row) const;
 	/** get the field indices for a row */
@@ -288,7 +463,7 @@ public:
 	bool sameBlock(GridPoint const& p1, GridPoint const& p2);
 
 
-	bool operator==(Sudoku const& other);
+	bool operator==(Sudoku const& other) const;
 
 	/**
 	 * Read a Sudoku from a stream. Format is as follows:
@@ -297,16 +472,15 @@ public:
 	 * - fields in each row/line separated by whitespace
 	 * - unsolved fields as "?"
 	 * - no comments allowed
+	 * Alternatively, the whole sudoku on a single line (e.g. 81
+	 * characters for 9x9), see SudokuParser. Reads only the lines of one
+	 * sudoku, so several can be read from the same stream.
 	 */
     friend std::istream& operator>>( std::istream  &input, Sudoku &sudoku );
     friend std::ostream& operator<<( std::ostream  &output, Sudoku const& sudoku );
 
 private:
 
-	void printFrameLine() const;
-
-	void printFrameLine2(size_t fieldWidth) const;
-
 	/** convert GridPoint p to the corresponding field index */
 	size_t xyToIndex(GridPoint const& p) const {
 		return p.x*m_sideLength + p.y;
@@ -323,18 +497,52 @@ private:
 	/** check possibility based on current solution */
 	bool checkPossible(size_t fieldIndex, size_t i);
 
+	/** saves the field into the trail before its first change */
+	void save(size_t fieldIndex) {
+		if(m_trail->saved[fieldIndex]==m_trail->recording) return;
+		m_trail->saved[fieldIndex]=m_trail->recording;
+		m_trail->entries.push_back({fieldIndex, m_possible[fieldIndex], m_solution[fieldIndex]});
+	}
+
 	/** change the possibility to enter number i into the
 	 * field with index fieldIndex to true */
 	void makePossible(size_t fieldIndex, size_t i) {
-		m_possible[fieldIndex].set(i-1);
+		CandidateMask number(CandidateMask(1) << (i-1));
+		if(m_possible[fieldIndex] & number) return;
+		if(m_trail) save(fieldIndex);
+		m_possible[fieldIndex] |= number;
+		setPositions(fieldIndex, number, true);
 	}
 
 	/** change the possibility to enter number i into the
 	 * field with index fieldIndex to false */
 	void makeImpossible(size_t fieldIndex, size_t i) {
-		m_possible[fieldIndex].reset(i-1);
+		CandidateMask number(CandidateMask(1) << (i-1));
+		if(!(m_possible[fieldIndex] & number)) return;
+		if(m_trail) save(fieldIndex);
+		m_possible[fieldIndex] &= ~number;
+		setPositions(fieldIndex, number, false);
 	}
 
+	/** replace all candidates of a field, keeping the position masks in sync */
+	void setCandidates(size_t fieldIndex, CandidateMask candidates) {
+		CandidateMask old(m_possible[fieldIndex]);
+		if(m_trail && old!=candidates) save(fieldIndex);
+		m_possible[fieldIndex] = candidates;
+		setPositions(fieldIndex, old & ~candidates, false);
+		setPositions(fieldIndex, candidates & ~old, true);
+	}
+
+	/** set or clear the bit of a field in the position masks of its
+	 * three houses for all given numbers */
+	void setPositions(size_t fieldIndex, CandidateMask numbers, bool possible);
+
+	/** recompute all position masks from the candidates */
+	void updatePositions();
+
+	/** recompute everything else from m_solution, see loadGivens */
+	size_t updateFromSolutions();
+
 	/** Factorizes an integer number n into two integer factors
 	 *  f1, f2 that are closest to the square root of the input number
 	 *  with f1 <= f2 */
@@ -355,14 +563,26 @@ private:
 	size_t m_nbSolved; /**< The number of fields that have already been solved */
 	size_t m_nbGuesses; /**< The number of ambiguities, that have been resolved */
 
-	// each field has a bitset of length "size" which for each number
-	// states whether it's still possible to enter this number
-	std::vector<DynamicBitset<>> m_possible;
+	// each field has a mask which for each number states
+	// whether it's still possible to enter this number
+	std::vector<CandidateMask> m_possible;
+
+	// index: house*sideLength + number-1
+	// for each house and number the positions within the house,
+	// where the number is still a candidate (see candidatePositions)
+	std::vector<CandidateMask> m_positions;
+
+	// index: number-1, see numberVersion
+	std::vector<size_t> m_numberVersions;
+	size_t m_version; /**< see version */
+	size_t m_nbCandidates; /**< the sum of the candidates of all fields */
 
 	// the actual solution of the Sudoku
 	// unsolved fields have value 0
 	std::vector<size_t> m_solution;
 
+	Trail* m_trail = nullptr; /**< see setTrail */
+
 	friend class SudokuSolver;
 
 };
@@ -1,14 +1,17 @@
 #include "SudokuGenerator.h"
 #include "SudokuScrambler.h"
+#include "FixedSudoku.h"
 #include <algorithm>
+#include <chrono>
 
 SudokuGenerator::SudokuGenerator(Settings const& settings, Sudoku && sudoku) :
 		m_settings(settings),
 		m_sudoku(sudoku),
 		m_targetNbSolvedFields(0),
 		m_nbAttempts(0),
+		m_timedOut(false),
 		m_processingOrder(m_sudoku.nbFields()),
-		m_randomEngine(m_randomDevice())
+		m_randomEngine(RandomEngine::makeSeed(m_settings.randomSeed()))
 {
 }
 
@@ -17,15 +20,26 @@ SudokuGenerator::SudokuGenerator(Settings && settings, Sudoku && sudoku) :
 		m_sudoku(sudoku),
 		m_targetNbSolvedFields(0),
 		m_nbAttempts(0),
+		m_timedOut(false),
 		m_processingOrder(m_sudoku.nbFields()),
-		m_randomEngine(m_randomDevice())
+		m_randomEngine(RandomEngine::makeSeed(m_settings.randomSeed()))
 {
 }
 
 bool SudokuGenerator::generate() {
 	m_settings.nextIterOnChange(true);
 	m_settings.maxResults(2);
+	size_t firstAttempt(m_nbAttempts);
+	m_timedOut=false;
+	bool hasDeadline(m_settings.maxGenerationMicroseconds()!=std::numeric_limits<size_t>::max());
+	std::chrono::steady_clock::time_point deadline;
+	if(hasDeadline) {
+		// limited to about 30 years, so that the time point cannot overflow
+		size_t microseconds(std::min<size_t>(m_settings.maxGenerationMicroseconds(), size_t(1) << 50));
+		deadline = std::chrono::steady_clock::now()+std::chrono::microseconds(microseconds);
+	}
 	m_sudoku.trivialSolution();
+	m_solver.reset(new SudokuSolver(m_settings, m_sudoku));
 	scramble();
 
 	std::uniform_real_distribution<float> randomFloat(
@@ -35,20 +49,28 @@ bool SudokuGenerator::generate() {
 			static_cast<float>(m_sudoku.nbFields())
 	);
 
-	std::cout << "m_targetNbSolvedFields = " << m_targetNbSolvedFields << std::endl;
+	if(m_settings.printProgress())
+		std::cout << "m_targetNbSolvedFields = " << m_targetNbSolvedFields << std::endl;
 
 	std::iota (std::begin(m_processingOrder), std::end(m_processingOrder), 0);
 	std::shuffle(m_processingOrder.begin(), m_processingOrder.end(), m_randomEngine);
 
 	while(!tryRemoveSolutionRandom()) {
-		if(m_nbAttempts%10000==0) std::cout << "attempt "<<m_nbAttempts << std::endl;
+		if(m_nbAttempts-firstAttempt>=m_settings.maxAttempts())
+			return false;
+		if(hasDeadline && std::chrono::steady_clock::now()>=deadline) {
+			m_timedOut=true;
+			return false;
+		}
+		if(m_settings.printProgress() && m_nbAttempts%10000==0)
+			std::cout << "attempt "<<m_nbAttempts << std::endl;
 	}
 	return true;
 //	return tryRemoveSolution(m_sudoku, 0, 0);
 }
 
 void SudokuGenerator::scramble() {
-	SudokuScrambler scrambler(m_sudoku);
+	SudokuScrambler scrambler(m_sudoku, m_randomEngine());
 	scrambler.scramble();
 	m_sudoku=scrambler.sudoku();
 }
@@ -67,11 +89,12 @@ bool SudokuGenerator::tryRemoveSolutionDeterministic(
 	sudoku.clearSolution(m_processingOrder[index]);
 	m_nbAttempts++;
 
+	if(!mayBeUnique(sudoku))
+		return false;
+
 	// check if it's still possible to solve this
-	SudokuSolver solver(
-			m_settings,
-			sudoku);
-	SudokuSolver::Result result = solver.solve();
+	SudokuSolver& solver(*m_solver);
+	SudokuSolver::Result result = solver.solve(sudoku);
 
 	// no solution => discard and next try;
 	if(result!=SudokuSolver::Result::solved)
@@ -97,16 +120,18 @@ bool SudokuGenerator::tryRemoveSolutionDeterministic(
 
 bool SudokuGenerator::tryRemoveSolutionRandom() {
 	m_nbAttempts++;
-	Sudoku sudoku(m_sudoku);
+	Sudoku& sudoku(m_scratch);
+	sudoku = m_sudoku;
 	std::shuffle(m_processingOrder.begin(), m_processingOrder.end(), m_randomEngine);
-	for(int i=0; i<m_targetNbSolvedFields; i++) {
-		sudoku.clearSolution(m_processingOrder[i]);
-	}
+	size_t nbCleared(std::min<size_t>(m_targetNbSolvedFields, m_processingOrder.size()));
+	sudoku.clearSolutions(m_processingOrder.begin(), m_processingOrder.begin()+nbCleared);
+
+	if(!mayBeUnique(sudoku))
+		return false;
+
 	// check if it's still possible to solve this
-	SudokuSolver solver(
-			m_settings,
-			sudoku);
-	SudokuSolver::Result result = solver.solve();
+	SudokuSolver& solver(*m_solver);
+	SudokuSolver::Result result = solver.solve(sudoku);
 
 	// no solution => discard and next try;
 	if(result!=SudokuSolver::Result::solved)
@@ -120,3 +145,9 @@ bool SudokuGenerator::tryRemoveSolutionRandom() {
 	m_solution = solver.getSolved()[0];
 	return true;
 }
+
+bool SudokuGenerator::mayBeUnique(Sudoku const& sudoku) const {
+	if(!hasFixedGeometry(sudoku.sideLength(), sudoku.blockWidth()))
+		return true;
+	return countSolutionsFixed(sudoku, 2)==1;
+}
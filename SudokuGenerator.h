@@ -4,7 +4,9 @@
 #include "Sudoku.h"
 #include "DataContainerMacro.h"
 #include "SudokuSolver.h"
-#include <random>
+#include "RandomEngine.h"
+#include <limits>
+#include <memory>
 
 class SudokuGenerator {
 
@@ -14,7 +16,12 @@ public:
 			((solverSettings,SudokuSolver::Settings, public)),
 			((minFilledRatio, float, 0.0, float))
 			((maxFilledRatio, float, 1.0, float))
-			((minNbGuesses, size_t, 0, size_t)),
+			((minNbGuesses, size_t, 0, size_t))
+			// generate() gives up after this many attempts or this time
+			((maxAttempts, size_t, std::numeric_limits<size_t>::max(), size_t))
+			((maxGenerationMicroseconds, size_t, std::numeric_limits<size_t>::max(), size_t))
+			// reports the target and every 10000th attempt on std::cout
+			((printProgress, bool, true, bool)),
 			(static Settings easy;)
 			(static Settings medium;)
 			(static Settings hard;)
@@ -24,6 +31,10 @@ public:
 
 	SudokuGenerator(Settings && settings, Sudoku && sudoku);
 
+	/**
+	 * Returns false if maxAttempts or maxGenerationMicroseconds ran out
+	 * first, see timedOut()
+	 */
 	bool generate();
 
 	Sudoku & getSudoku() { return m_sudoku; }
@@ -34,6 +45,9 @@ public:
 
 	size_t nbAttempts() const { return m_nbAttempts; }
 
+	/** Whether the last generate() ran out of time */
+	bool timedOut() const { return m_timedOut; }
+
 private:
 	void scramble();
 
@@ -56,15 +70,27 @@ private:
 	 */
 	bool tryRemoveSolutionRandom();
 
+	/*
+	 * quick uniqueness check with the FixedSudoku engine before running the
+	 * (much slower) rating solver. Returns true if the check cannot be done
+	 * because there is no specialization for the geometry.
+	 */
+	bool mayBeUnique(Sudoku const& sudoku) const;
+
 	Settings m_settings;
 	Sudoku m_sudoku;
 	Sudoku m_solution;
+	// reused for every attempt of tryRemoveSolutionRandom
+	Sudoku m_scratch;
+	// checks the attempts, reused to keep its buffers (see SudokuSolver::reset)
+	std::unique_ptr<SudokuSolver> m_solver;
     float m_targetNbSolvedFields;
     size_t m_nbAttempts;
+    bool m_timedOut;
     std::vector<size_t> m_processingOrder;
 
-    std::random_device m_randomDevice;
-    std::default_random_engine m_randomEngine;
+    // seeded from randomSeed, also seeds the scrambler
+    RandomEngine m_randomEngine;
 };
 
 #endif /* SUDOKUGENERATOR_H_ */
@@ -0,0 +1,211 @@
+#include "SudokuParser.h"
+#include <algorithm>
+#include <cmath>
+#include <istream>
+#include <stdexcept>
+
+namespace {
+
+bool isBlank(char c) {
+	return c==' ' || c=='\t' || c=='\r';
+}
+
+char const* skipBlanks(char const* p, char const* end) {
+	while(p!=end && isBlank(*p)) ++p;
+	return p;
+}
+
+char const* skipWord(char const* p, char const* end) {
+	while(p!=end && !isBlank(*p) && *p!='\n') ++p;
+	return p;
+}
+
+size_t countWords(char const* p, char const* end) {
+	size_t nbWords(0);
+	while(true) {
+		p=skipBlanks(p, end);
+		if(p==end || *p=='\n') return nbWords;
+		++nbWords;
+		p=skipWord(p, end);
+	}
+}
+
+} // namespace
+
+char const* SudokuParser::parse(char const* begin, char const* end, Sudoku & sudoku)
+{
+	m_text=begin;
+	char const* line(begin);
+	char const* word;
+	while(true) {
+		word=skipBlanks(line, end);
+		if(word==end)
+			fail(word, "no sudoku found");
+		if(*word!='\n')
+			break;
+		line=word+1;
+	}
+	char const* wordEnd(skipWord(word, end));
+	char const* next;
+	if(countWords(wordEnd, end)==0)
+		next=parseSingleLine(word, wordEnd, end);
+	else {
+		m_sideLength=countWords(line, end);
+		next=parseGrid(line, end);
+	}
+	fill(sudoku);
+	return next;
+}
+
+void SudokuParser::parse(std::string const& text, Sudoku & sudoku)
+{
+	char const* end(text.data()+text.size());
+	char const* next(parse(text.data(), end, sudoku));
+	if(!atEnd(next, end))
+		fail(next, "unexpected text after the sudoku");
+}
+
+bool SudokuParser::atEnd(char const* begin, char const* end)
+{
+	return std::all_of(begin, end, [](char c) {return isBlank(c) || c=='\n';});
+}
+
+char const* SudokuParser::parseGrid(char const* line, char const* end)
+{
+	size_t sideLength(m_sideLength);
+	if(sideLength>Sudoku::maxSideLength)
+		fail(line, "a row of "+std::to_string(sideLength)+" cells is too long for a sudoku");
+	m_values.resize(sideLength*sideLength);
+	m_positions.resize(sideLength*sideLength);
+	for(size_t y(0); y<sideLength; ++y) {
+		if(line==end)
+			fail(line, "expected "+std::to_string(sideLength)+" rows, found "+std::to_string(y));
+		size_t x(0);
+		char const* p(line);
+		while(true) {
+			p=skipBlanks(p, end);
+			if(p==end || *p=='\n')
+				break;
+			char const* word(p);
+			p=skipWord(p, end);
+			if(x==sideLength)
+				fail(word, "more than "+std::to_string(sideLength)+" cells in a row");
+			m_values[x*sideLength+y]=gridNumber(word, p);
+			m_positions[x*sideLength+y]=word;
+			++x;
+		}
+		if(x<sideLength)
+			fail(p, "expected "+std::to_string(sideLength)+" cells in a row, found "+std::to_string(x));
+		line = p==end ? end : p+1;
+	}
+	return line;
+}
+
+char const* SudokuParser::parseSingleLine(
+		char const* word,
+		char const* wordEnd,
+		char const* end
+) {
+	size_t nbCells(wordEnd-word);
+	size_t sideLength(std::lround(std::sqrt(static_cast<double>(nbCells))));
+	if(sideLength*sideLength!=nbCells)
+		fail(word, "a single-line sudoku needs a square number of cells, found "+std::to_string(nbCells));
+	if(sideLength>35)
+		fail(word, "single-line sudokus are limited to a side length of 35");
+	m_sideLength=sideLength;
+	m_values.resize(nbCells);
+	m_positions.resize(nbCells);
+	for(size_t i(0); i<nbCells; ++i) {
+		char c(word[i]);
+		size_t number;
+		if(c=='.' || c=='0')
+			number=0;
+		else if(c>='1' && c<='9')
+			number=c-'0';
+		else if(c>='A' && c<='Z')
+			number=c-'A'+10;
+		else if(c>='a' && c<='z')
+			number=c-'a'+10;
+		else
+			fail(word+i, std::string("invalid cell '")+c+"'");
+		if(number>sideLength)
+			fail(word+i, "number "+std::to_string(number)+" is larger than the side length "+std::to_string(sideLength));
+		// the cells are row by row, the fields column by column
+		size_t fieldIndex((i%sideLength)*sideLength+i/sideLength);
+		m_values[fieldIndex]=number;
+		m_positions[fieldIndex]=word+i;
+	}
+	char const* lineEnd(std::find(wordEnd, end, '\n'));
+	return lineEnd==end ? end : lineEnd+1;
+}
+
+size_t SudokuParser::gridNumber(char const* begin, char const* end) const
+{
+	if(end-begin==1 && (*begin=='?' || *begin=='.'))
+		return 0;
+	size_t number(0);
+	for(char const* p(begin); p!=end; ++p) {
+		if(*p<'0' || *p>'9' || end-begin>3)
+			fail(begin, "invalid cell '"+std::string(begin, end)+"'");
+		number=10*number+(*p-'0');
+	}
+	if(number>m_sideLength)
+		fail(begin, "number "+std::to_string(number)+" is larger than the side length "+std::to_string(m_sideLength));
+	return number;
+}
+
+void SudokuParser::fill(Sudoku & sudoku)
+{
+	size_t sideLength(m_sideLength);
+	if(m_empty.sideLength()!=sideLength) {
+		try {
+			m_empty=Sudoku(sideLength);
+		} catch(std::exception &e) {
+			fail(m_positions[0], e.what());
+		}
+	}
+	// only a sudoku of another geometry needs new storage
+	if(sudoku.sideLength()!=sideLength || sudoku.blockWidth()!=m_empty.blockWidth())
+		sudoku=m_empty;
+	size_t conflict(sudoku.loadGivens(m_values));
+	if(conflict<m_values.size())
+		fail(m_positions[conflict], std::to_string(m_values[conflict])
+				+" conflicts with another given in its row, column or block");
+}
+
+void SudokuParser::fail(char const* position, std::string const& message) const
+{
+	size_t line(1+std::count(m_text, position, '\n'));
+	char const* lineStart(position);
+	while(lineStart!=m_text && lineStart[-1]!='\n') --lineStart;
+	throw std::runtime_error("line "+std::to_string(line)+", column "
+			+std::to_string(position-lineStart+1)+": "+message);
+}
+
+std::istream &operator>>( std::istream  &input, Sudoku &sudoku )
+{
+	// collects the lines of one sudoku, the first non-empty line tells
+	// the format and thus the number of lines
+	thread_local SudokuParser parser;
+	thread_local std::string text;
+	thread_local std::string line;
+	text.clear();
+	size_t nbLines(0);
+	size_t nbRead(0);
+	while(nbRead<nbLines || nbLines==0) {
+		if(!getline(input, line))
+			break;
+		if(nbLines==0) {
+			size_t nbWords(countWords(line.data(), line.data()+line.size()));
+			if(nbWords==0) continue;
+			nbLines=nbWords==1 ? 1 : nbWords;
+		}
+		text += line;
+		text += '\n';
+		++nbRead;
+	}
+	if(nbLines==0)
+		throw std::runtime_error("empty sudoku");
+	parser.parse(text, sudoku);
+	return input;
+}
@@ -0,0 +1,68 @@
+#ifndef SUDOKUPARSER_H_
+#define SUDOKUPARSER_H_
+
+#include "Sudoku.h"
+#include <string>
+#include <vector>
+
+/**
+ * Parses sudokus from a character buffer without tokenizing into strings.
+ * Two formats are accepted:
+ *
+ * - grid: one line per row with the cells separated by blanks, each cell
+ *   a decimal number or "?", "." or "0" if it is empty (the format
+ *   written by operator<<)
+ * - single line: all cells row by row as one word of sideLength^2
+ *   characters: "." or "0" for an empty cell, then 1-9 and A-Z (base 36,
+ *   either case) for the numbers, e.g. the common 81 character format
+ *
+ * Empty lines before a sudoku are skipped. Errors throw a
+ * std::runtime_error naming the line and column.
+ *
+ * The parser keeps its buffers, and parsing into a sudoku of the same
+ * geometry reuses the sudoku's storage. So parsing many puzzles with one
+ * parser does not allocate.
+ */
+class SudokuParser {
+
+public:
+
+	/**
+	 * Parses the first sudoku in [begin, end) into sudoku. Returns the
+	 * position after it, where the next one may start.
+	 */
+	char const* parse(char const* begin, char const* end, Sudoku & sudoku);
+
+	/** Parses a text that contains exactly one sudoku */
+	void parse(std::string const& text, Sudoku & sudoku);
+
+	/** Whether only blanks and line breaks are left in [begin, end) */
+	static bool atEnd(char const* begin, char const* end);
+
+private:
+
+	// the rows of the grid format, returns the end of the last row
+	char const* parseGrid(char const* line, char const* end);
+
+	// the single line format, returns the end of the line
+	char const* parseSingleLine(char const* word, char const* wordEnd, char const* end);
+
+	// the number of a grid cell
+	size_t gridNumber(char const* begin, char const* end) const;
+
+	// loads m_values into the sudoku, reporting conflicts
+	void fill(Sudoku & sudoku);
+
+	[[noreturn]] void fail(char const* position, std::string const& message) const;
+
+	// the text being parsed, for line and column numbers
+	char const* m_text = nullptr;
+	size_t m_sideLength = 0;
+	// the cells in field index order, 0 if empty
+	std::vector<size_t> m_values;
+	// where each cell is in the text
+	std::vector<char const*> m_positions;
+	Sudoku m_empty;
+};
+
+#endif /* SUDOKUPARSER_H_ */
@@ -1,11 +1,10 @@
 #include "SudokuScrambler.h"
 #include <random>
 
-SudokuScrambler::SudokuScrambler(const Sudoku& sudoku) :
+SudokuScrambler::SudokuScrambler(const Sudoku& sudoku, uint64_t seed) :
 	m_sudoku(sudoku),
 	m_totSteps(0),
-	m_randomDevice(),
-	m_randomEngine(m_randomDevice()),
+	m_randomEngine(RandomEngine::makeSeed(seed)),
 	m_uniformDistRowCol(0,m_sudoku.sideLength()-1),
 	m_uniformDistBlockRows(0,m_sudoku.nbBlockRows()-1),
 	m_uniformDistBlockColumns(0,m_sudoku.nbBlockColumns()-1)
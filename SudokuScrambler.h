@@ -2,11 +2,12 @@
 #define SUDOKUSCRAMBLER_H_
 
 #include "Sudoku.h"
-#include <random>
+#include "RandomEngine.h"
 
 class SudokuScrambler {
 public:
-	SudokuScrambler(Sudoku const& sudoku);
+	/** A seed of 0 draws a fresh one, see RandomEngine::makeSeed */
+	SudokuScrambler(Sudoku const& sudoku, uint64_t seed=0);
 
 	Sudoku const& sudoku() const { return m_sudoku; }
 
@@ -28,8 +29,7 @@ private:
 	Sudoku m_sudoku;
 	size_t m_totSteps;
 
-    std::random_device m_randomDevice;
-    std::default_random_engine m_randomEngine;
+    RandomEngine m_randomEngine;
     std::uniform_int_distribution<size_t> m_uniformDistRowCol;
     std::uniform_int_distribution<size_t> m_uniformDistBlockRows;
     std::uniform_int_distribution<size_t> m_uniformDistBlockColumns;
@@ -0,0 +1,289 @@
+#include "SudokuServer.h"
+#include "SudokuGenerator.h"
+#include "SudokuSolver.h"
+#include "Socket.h"
+#include <array>
+#include <deque>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+char const* const difficulties[] = {"easy", "medium", "hard", "extreme"};
+
+// the largest geometry with a FixedSudoku specialization; above it the
+// generator may need far more attempts than a request can wait for
+size_t const maxGeneratedSideLength(25);
+
+size_t toDifficulty(std::string const& name) {
+	for(size_t d(0); d<4; ++d)
+		if(name==difficulties[d])
+			return d;
+	throw std::runtime_error("could not interpret "+name+" as difficulty");
+}
+
+SudokuSolver::Settings const& solverPreset(size_t difficulty) {
+	SudokuSolver::Settings const* settings[] = {
+		&SudokuSolver::Settings::easy,
+		&SudokuSolver::Settings::medium,
+		&SudokuSolver::Settings::hard,
+		&SudokuSolver::Settings::extreme
+	};
+	return *settings[difficulty];
+}
+
+SudokuGenerator::Settings const& generatorPreset(size_t difficulty) {
+	SudokuGenerator::Settings const* settings[] = {
+		&SudokuGenerator::Settings::easy,
+		&SudokuGenerator::Settings::medium,
+		&SudokuGenerator::Settings::hard,
+		&SudokuGenerator::Settings::extreme
+	};
+	return *settings[difficulty];
+}
+
+/*
+ * The warm solver of the calling worker thread for a difficulty. It stops
+ * after two solutions, which is enough to tell whether the solution is
+ * unique. The solvers live as long as the thread and are created with the
+ * time limit of the first request, one server per process is assumed.
+ */
+SudokuSolver& workerSolver(size_t difficulty, Sudoku const& sudoku, size_t maxMicroseconds) {
+	thread_local std::array<std::unique_ptr<SudokuSolver>, 4> solvers;
+	std::unique_ptr<SudokuSolver> & solver(solvers[difficulty]);
+	if(!solver) {
+		SudokuSolver::Settings settings(solverPreset(difficulty));
+		settings.maxResults(2);
+		settings.maxMicroseconds(maxMicroseconds);
+		solver.reset(new SudokuSolver(settings, sudoku));
+	}
+	return *solver;
+}
+
+// a given number sent by a client, one of 1..sideLength
+size_t readNumber(std::string const& cell, size_t sideLength) {
+	size_t number(0);
+	for(char c : cell) {
+		if(c<'0' || c>'9' || number>sideLength)
+			throw std::runtime_error("invalid cell "+cell);
+		number = 10*number+(c-'0');
+	}
+	if(number<1 || number>sideLength)
+		throw std::runtime_error("invalid cell "+cell);
+	return number;
+}
+
+/*
+ * Reads the side length and the cells row by row. The givens are loaded in
+ * one pass with Sudoku::loadGivens, which reports conflicting givens
+ * instead of printing the board like enterSolution does.
+ */
+Sudoku readSudoku(std::istream & is) {
+	size_t sideLength(0);
+	if(!(is >> sideLength) || sideLength<2 || sideLength>Sudoku::maxSideLength)
+		throw std::runtime_error("invalid side length");
+	std::vector<size_t> numbers(sideLength*sideLength, 0);
+	std::string cell;
+	for(size_t y(0); y<sideLength; ++y) {
+		for(size_t x(0); x<sideLength; ++x) {
+			if(!(is >> cell))
+				throw std::runtime_error("too few cells");
+			if(cell!="?")
+				numbers[x*sideLength+y]=readNumber(cell, sideLength);
+		}
+	}
+	Sudoku sudoku(sideLength);
+	if(sudoku.loadGivens(numbers)!=sudoku.nbFields())
+		throw std::runtime_error("conflicting givens");
+	return sudoku;
+}
+
+void writeSudoku(std::ostream & os, Sudoku const& sudoku) {
+	os << sudoku.sideLength();
+	GridPoint p(0, 0);
+	for(p.y=0; p.y<sudoku.sideLength(); ++p.y) {
+		for(p.x=0; p.x<sudoku.sideLength(); ++p.x) {
+			size_t number(sudoku.getSolution(p));
+			if(number>0)
+				os << ' ' << number;
+			else
+				os << " ?";
+		}
+	}
+}
+
+} // namespace
+
+SudokuServer::SudokuServer(Options const& options) :
+		m_options(options),
+		m_pool(options.nbThreads, options.maxQueueDepth),
+		m_listener(listenOn(options.address))
+{}
+
+SudokuServer::~SudokuServer()
+{
+	stop();
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_connectionsDone.wait(lock, [this] {return m_connections.empty();});
+	closeSocket(m_listener);
+}
+
+void SudokuServer::run()
+{
+	while(true) {
+		int fd(acceptConnection(m_listener));
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(m_stopping) {
+			if(fd>=0) closeSocket(fd);
+			return;
+		}
+		if(fd<0)
+			throw std::runtime_error("SudokuServer: accept failed");
+		m_connections.insert(fd);
+		std::thread(&SudokuServer::serveConnection, this, fd).detach();
+	}
+}
+
+void SudokuServer::stop()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if(m_stopping) return;
+	m_stopping=true;
+	shutdownSocket(m_listener);
+	for(int fd : m_connections)
+		shutdownSocket(fd);
+}
+
+void SudokuServer::serveConnection(int fd)
+{
+	// the responses in request order, the writer waits for each in turn
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<std::future<std::string>> pending;
+	bool done(false);
+	bool broken(false);
+
+	std::thread writer([&] {
+		while(true) {
+			std::future<std::string> next;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&] {return done || !pending.empty();});
+				if(pending.empty())
+					return;
+				next=std::move(pending.front());
+				pending.pop_front();
+			}
+			changed.notify_all();
+			if(!writeAll(fd, next.get()+"\n")) {
+				std::lock_guard<std::mutex> lock(mutex);
+				broken=true;
+				shutdownSocket(fd);
+			}
+		}
+	});
+
+	LineReader reader(fd);
+	std::string line;
+	while(reader.readLine(line)) {
+		if(line.find_first_not_of(" \t")==std::string::npos)
+			continue;
+		if(line=="quit")
+			break;
+		auto task(std::make_shared<std::packaged_task<std::string()>>(
+				[this, line] {return handle(line);}));
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [&] {return broken || pending.size()<m_options.maxPipelined;});
+			if(broken)
+				break;
+			pending.push_back(task->get_future());
+		}
+		changed.notify_all();
+		// blocks while the pool is saturated, which stops reading from
+		// the client until the workers catch up
+		m_pool.submit([task] {(*task)();});
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		done=true;
+	}
+	changed.notify_all();
+	writer.join();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	closeSocket(fd);
+	m_connections.erase(fd);
+	if(m_connections.empty())
+		m_connectionsDone.notify_all();
+}
+
+std::string SudokuServer::handle(std::string const& request)
+{
+	std::istringstream is(request);
+	std::ostringstream os;
+	std::string command;
+	is >> command;
+	try {
+		if(command=="solve") {
+			std::string difficulty;
+			is >> difficulty;
+			size_t d(toDifficulty(difficulty));
+			Sudoku sudoku(readSudoku(is));
+			SudokuSolver& solver(workerSolver(d, sudoku, m_options.maxMicroseconds));
+			SudokuSolver::Result result(solver.solve(sudoku));
+			if(result==SudokuSolver::Result::solved) {
+				os << "solved " << (solver.getSolved().size()==1 ? "unique " : "multiple ");
+				writeSudoku(os, solver.getSolved().front());
+			} else
+				os << result;
+		} else if(command=="rate") {
+			Sudoku sudoku(readSudoku(is));
+			os << "rated ";
+			size_t d(0);
+			for(; d<4; ++d) {
+				SudokuSolver& solver(workerSolver(d, sudoku, m_options.maxMicroseconds));
+				if(solver.solve(sudoku)==SudokuSolver::Result::solved && solver.getSolved().size()==1)
+					break;
+			}
+			os << (d<4 ? difficulties[d] : "none");
+		} else if(command=="generate") {
+			std::string difficulty;
+			size_t sideLength(0);
+			is >> difficulty >> sideLength;
+			size_t d(toDifficulty(difficulty));
+			if(sideLength<2 || sideLength>maxGeneratedSideLength)
+				throw std::runtime_error("invalid side length");
+			// each attempt and the whole generation share the time limit
+			SudokuGenerator::Settings settings(generatorPreset(d));
+			settings.maxMicroseconds(m_options.maxMicroseconds);
+			settings.maxGenerationMicroseconds(m_options.maxMicroseconds);
+			settings.printProgress(false);
+			SudokuGenerator generator(settings, Sudoku(sideLength));
+			if(generator.generate()) {
+				os << "generated ";
+				writeSudoku(os, generator.sudoku());
+				os << ' ';
+				writeSudoku(os, generator.getSolution());
+			} else if(generator.timedOut())
+				os << "timeout";
+			else
+				os << "failed";
+		} else if(command=="metrics") {
+			ThreadPool::Metrics metrics(m_pool.metrics());
+			os << "metrics queue " << metrics.queueDepth
+					<< " peak " << metrics.peakQueueDepth
+					<< " running " << metrics.running
+					<< " completed " << metrics.completed
+					<< " rejected " << metrics.rejected;
+		} else
+			throw std::runtime_error("unknown command "+command);
+	} catch(std::exception &e) {
+		return std::string("error ")+e.what();
+	}
+	return os.str();
+}
@@ -0,0 +1,83 @@
+#ifndef SUDOKUSERVER_H_
+#define SUDOKUSERVER_H_
+
+#include "ThreadPool.h"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <string>
+
+/**
+ * A long-running solve/generate service on a unix or TCP socket (see
+ * Socket.h for the addresses). Each request is one line, each response
+ * is one line. Clients may pipeline: requests of a connection run in
+ * parallel on the worker pool, the responses come back in request order.
+ *
+ * Sudokus are written as the side length followed by all cells row by
+ * row, "?" for an empty cell, e.g. "4 1 ? ? 2 ...". Numbers outside
+ * 1..sideLength and conflicting givens are answered with an error.
+ *
+ * requests:
+ *   solve <difficulty> <sudoku>
+ *   rate <sudoku>
+ *   generate <difficulty> <sideLength>   (sideLength at most 25)
+ *   metrics
+ *   quit
+ * responses:
+ *   solved unique|multiple <solution>
+ *   impossible | ambiguous | timeout
+ *   rated easy|medium|hard|extreme|none
+ *   generated <sudoku> <solution>
+ *   failed | timeout
+ *   metrics queue <n> peak <n> running <n> completed <n> rejected <n>
+ *   error <message>
+ *
+ * rate returns the easiest preset that solves the sudoku uniquely. The
+ * workers keep one solver per difficulty, so requests do not pay for the
+ * solver setup.
+ */
+class SudokuServer {
+
+public:
+
+	struct Options {
+		std::string address = "tcp:7878";
+		/*! 0: one per hardware thread */
+		size_t nbThreads = 0;
+		size_t maxQueueDepth = 1024;
+		/*! unanswered requests per connection before reading pauses */
+		size_t maxPipelined = 256;
+		/*! time limit of each solve or generate, answered with "timeout" */
+		size_t maxMicroseconds = 1000000;
+	};
+
+	explicit SudokuServer(Options const& options);
+
+	/** Stops and waits for the open connections */
+	~SudokuServer();
+
+	/** Accepts connections until stop() is called */
+	void run();
+
+	/** Makes run() return and closes all connections, thread-safe */
+	void stop();
+
+	/** The response to a single request line */
+	std::string handle(std::string const& request);
+
+private:
+
+	void serveConnection(int fd);
+
+	Options m_options;
+	ThreadPool m_pool;
+	int m_listener;
+	bool m_stopping = false;
+	std::mutex m_mutex;
+	// the open connections, each served by its own threads
+	std::set<int> m_connections;
+	std::condition_variable m_connectionsDone;
+};
+
+#endif /* SUDOKUSERVER_H_ */
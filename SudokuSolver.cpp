@@ -1,125 +1,559 @@
 #include "SudokuSolver.h"
 #include "Utility.h"
+#include "AllocationCounter.h"
 #include <iomanip>
 #include <random>
 #include <algorithm>
 #include <set>
+#include <chrono>
 
 std::ostream& operator << (std::ostream& os, GuessMode res) {
 	os << static_cast<int>(res);
 	return os;
 }
 
+std::ostream& operator << (std::ostream& os, Branching branching) {
+	os << static_cast<int>(branching);
+	return os;
+}
+
 SudokuSolver::SudokuSolver(
 		Settings const& settings,
-		Sudoku const& sudoku,
-		size_t depth
+		Sudoku const& sudoku
 ) :
 		m_settings(settings),
 		m_sudoku(sudoku),
-		m_depth(depth+1)
-{}
+		m_randomEngine(RandomEngine::makeSeed(settings.randomSeed()))
+{
+	registerStrategies();
+	reserveScratch();
+}
 
 SudokuSolver::SudokuSolver(
 		SudokuSolver const& other
 ) :
 		m_settings(other.m_settings),
 		m_sudoku(other.m_sudoku),
-		m_depth(other.m_depth+1)
-{}
+		m_strategies(other.m_strategies),
+		m_coloringSteps(other.m_coloringSteps),
+		m_xyWingSteps(other.m_xyWingSteps),
+		m_xyChainSteps(other.m_xyChainSteps),
+		m_randomEngine(RandomEngine::makeSeed(other.m_settings.randomSeed()))
+{
+	reserveScratch();
+}
 
 SudokuSolver::Result SudokuSolver::solve() {
+	m_nbFrames = 0;
+	m_atRoot = true;
+	return runMeasured(false);
+}
+
+void SudokuSolver::reset(Sudoku const& sudoku) {
+	bool sameGeometry(
+			sudoku.sideLength()==m_sudoku.sideLength() &&
+			sudoku.blockWidth()==m_sudoku.blockWidth());
+	m_sudoku = sudoku;
+	m_changed = false;
+	m_results.clear();
+	m_nbFrames = 0;
+	m_result = Result::ambiguos;
+	m_canRestart = false;
+	m_nbRestarts = 0;
+	m_restartBacktracks = 0;
+	// the versions of the new sudoku cannot be compared to the old ones
+	invalidateDerived();
+	m_stats = SolverStats();
+	m_coloringSteps = 0;
+	m_xyWingSteps = 0;
+	m_xyChainSteps = 0;
+	// with a seed, every solve makes the same random choices
+	if(m_settings.randomSeed()!=0)
+		m_randomEngine.reseed(m_settings.randomSeed());
+	if(!sameGeometry)
+		reserveScratch();
+}
+
+SudokuSolver::Result SudokuSolver::solve(Sudoku const& sudoku) {
+	reset(sudoku);
+	return solve();
+}
+
+SudokuSolver::Result SudokuSolver::solve(SearchFrame const& frame) {
+	reset(frame.sudoku);
+	if(m_frames.empty())
+		m_frames.push_back(frame);
+	else
+		m_frames[0] = frame;
+	m_nbFrames = 1;
+	m_atRoot = false;
+	if(!nextGuess())
+		return m_result = Result::impossible;
+	return runMeasured(false);
+}
+
+SudokuSolver::Result SudokuSolver::resume() {
+	return runMeasured(true);
+}
+
+SudokuSolver::Result SudokuSolver::runMeasured(bool continued) {
+	size_t allocations(AllocationCounter::count());
+	startBudgets();
+	if(!continued)
+		m_result = runSearch();
+	else if(m_result==Result::timeout)
+		m_result = runSearch();
+	else if(m_result==Result::solved && nextGuess())
+		// the board held the last solution, now it holds the next guess
+		m_result = runSearch();
+	if(continued)
+		m_stats.allocations += AllocationCounter::count()-allocations;
+	else
+		m_stats.allocations = AllocationCounter::count()-allocations;
+	return m_result;
+}
+
+bool SudokuSolver::splitFrontier(SearchFrame & frame) {
+	if(m_nbFrames==0) return false;
+	frame = m_frames[0];
+	// keep the storage of the removed frame behind the open ones
+	std::rotate(m_frames.begin(), m_frames.begin()+1, m_frames.begin()+m_nbFrames);
+	--m_nbFrames;
+	return true;
+}
+
+SudokuSolver::Result SudokuSolver::runSearch() {
+	while(true) {
+		Result result(propagate());
+		if(result==Result::timeout)
+			return result;
+		bool atRoot(m_atRoot);
+		m_atRoot = false;
+		if(result==Result::solved) {
+			m_results.push_back(m_sudoku);
+			if(m_results.size()>=m_settings.maxResults())
+				break;
+		} else if(canBranch()) {
+			if(atRoot && m_settings.restartBacktracks()>0
+					&& m_settings.guessMode()==GuessMode::Random) {
+				m_restartPoint.sudoku = m_sudoku;
+				m_restartPoint.coloringSteps = m_coloringSteps;
+				m_restartPoint.xyWingSteps = m_xyWingSteps;
+				m_restartPoint.xyChainSteps = m_xyChainSteps;
+				m_canRestart = true;
+				++m_stats.search.boardCopies;
+			}
+			if(branch())
+				continue;
+			++m_stats.search.backtracks;
+		} else if(atRoot)
+			return Result::ambiguos;
+		else
+			++m_stats.search.backtracks;
+		if(restartDue()) {
+			restart();
+			continue;
+		}
+		if(!nextGuess())
+			break;
+	}
+	return m_results.empty() ? Result::impossible : Result::solved;
+}
+
+SudokuSolver::Result SudokuSolver::propagate() {
+
+	if(m_stats.search.nodes>=m_nodeLimit)
+		return Result::timeout;
+	++m_stats.search.nodes;
+	m_stats.search.maxDepth = std::max(m_stats.search.maxDepth, m_sudoku.nbGuesses());
 
 	Result iterationResult;
 	do {
-//		std::cout << "NEXT ITERATION\n";
+		if(interrupted())
+			return Result::timeout;
+		size_t allocations(AllocationCounter::count());
 		iterationResult=solveIteration();
+		m_stats.iterationAllocations += AllocationCounter::count()-allocations;
 	} while(iterationResult==Result::ambiguos && m_changed);
+	return iterationResult;
+}
 
-	if(iterationResult==Result::solved)
-		return Result::solved;
-	else if(iterationResult==Result::impossible)
-		return Result::impossible;
-	else if(m_sudoku.nbGuesses()>=m_settings.maxNbGuesses()) {
-//		std::cout << "MAX GUESSES REACHED\n" << m_sudoku.nbGuesses() << " vs " << m_maxAmbiguities << std::endl;
-		return Result::ambiguos;
+void SudokuSolver::startBudgets() {
+	size_t maxNodes(m_settings.maxNodes());
+	size_t nodes(m_stats.search.nodes);
+	m_nodeLimit = maxNodes>std::numeric_limits<size_t>::max()-nodes ?
+			std::numeric_limits<size_t>::max() : nodes+maxNodes;
+	m_hasDeadline = m_settings.maxMicroseconds()!=std::numeric_limits<size_t>::max();
+	if(m_hasDeadline) {
+		// limited to about 30 years, so that the time point cannot overflow
+		size_t microseconds(std::min<size_t>(m_settings.maxMicroseconds(), size_t(1) << 50));
+		m_deadline = std::chrono::steady_clock::now()+std::chrono::microseconds(microseconds);
 	}
+}
 
-	if(m_settings.guessMode()==GuessMode::Deterministic)
-		educatedGuess();
-	else if(m_settings.guessMode()==GuessMode::Random)
-		randomGuess();
+bool SudokuSolver::interrupted() const {
+	if(m_cancellation && m_cancellation->cancelled())
+		return true;
+	return m_hasDeadline && std::chrono::steady_clock::now()>=m_deadline;
+}
 
-	if(m_results.empty())
-		return Result::impossible;
-	else
-		return Result::solved;
+bool SudokuSolver::canBranch() {
+	if(m_sudoku.nbGuesses()>=m_settings.maxNbGuesses())
+		return false;
+	// the frame needs a copy of the board
+	size_t frameSize(sizeof(SearchFrame)+m_sudoku.memoryUsage()-sizeof(Sudoku));
+	if((m_nbFrames+1)*frameSize>m_settings.maxSearchMemory()) {
+		++m_stats.search.memoryCutoffs;
+		return false;
+	}
+	return true;
 }
 
-SudokuSolver::Result SudokuSolver::solveIteration() {
+bool SudokuSolver::branch() {
+	size_t nbFields(m_sudoku.nbFields());
+	size_t fieldIndex(nbFields);
+	size_t number(0);
+	Sudoku::CandidateMask untried(0);
+	if(m_settings.guessMode()==GuessMode::Random) {
+		// the k-th unsolved field
+		size_t k(std::uniform_int_distribution<size_t>(0, m_sudoku.nbUnsolved()-1)(m_randomEngine));
+		for(size_t f=0; f<nbFields; f++) {
+			if(m_sudoku.isSolved(f))
+				continue;
+			if(k==0) {
+				fieldIndex=f;
+				break;
+			}
+			--k;
+		}
+		if(fieldIndex==nbFields)
+			throw std::runtime_error("SudokuSolver::branch no unsolved field");
+		untried=m_sudoku.candidateMask(fieldIndex);
+	} else {
+		fieldIndex=selectField();
+		if(fieldIndex==nbFields)
+			return false;
+		untried=m_sudoku.candidateMask(fieldIndex);
+		size_t house;
+		if(m_settings.branching()==Branching::FewestPositions
+				&& selectPositions(popCount(untried), house, number)) {
+			fieldIndex=house;
+			untried=m_sudoku.candidatePositions(house, number);
+		}
+	}
+	if(!untried)
+		return false;
 
-	m_changed = false;
+	size_t guessedNumber;
+	size_t guessedField(takeGuess(m_sudoku, fieldIndex, number, untried, guessedNumber));
+	if(untried) {
+		// copy-assignment reuses the board of a previous frame at this depth
+		if(m_nbFrames==m_frames.size())
+			m_frames.push_back(SearchFrame{m_sudoku, 0, 0, 0, 0, 0, 0});
+		else
+			m_frames[m_nbFrames].sudoku = m_sudoku;
+		SearchFrame & frame(m_frames[m_nbFrames++]);
+		frame.fieldIndex = fieldIndex;
+		frame.untried = untried;
+		frame.coloringSteps = m_coloringSteps;
+		frame.xyWingSteps = m_xyWingSteps;
+		frame.xyChainSteps = m_xyChainSteps;
+		frame.number = number;
+		++m_stats.search.boardCopies;
+	}
+	// the board continues into the first guess, so what is idle stays idle
+	m_sudoku.enterSolution(guessedField, guessedNumber, true);
+	return true;
+}
+
+size_t SudokuSolver::selectField() const {
+	size_t nbFields(m_sudoku.nbFields());
+	size_t fieldIndex(nbFields);
+	size_t minPossible(m_sudoku.sideLength()+1);
+	// without naked singles, a field may be left with one candidate
+	size_t lowest(m_settings.allowNakedSingle() ? 2 : 1);
+	bool breakTies(m_settings.branching()==Branching::MostConstrained);
+	for(size_t f=0; f<nbFields; f++) {
+		if(m_sudoku.isSolved(f))
+			continue;
+		size_t nbCandidates(m_sudoku.nbCandidates(f));
+		if(nbCandidates==0)
+			return nbFields;
+		if(nbCandidates < minPossible) {
+			minPossible=nbCandidates;
+			fieldIndex=f;
+			// nothing can beat it, only a contradiction would be missed
+			if(nbCandidates<=lowest && !breakTies)
+				break;
+		}
+	}
+	if(!breakTies || fieldIndex==nbFields)
+		return fieldIndex;
+
+	// the unsolved fields of each house are the numbers not yet placed in it
+	std::array<size_t, 3*Sudoku::maxSideLength> unsolved;
+	for(size_t house(0); house<m_sudoku.nbHouses(); ++house) {
+		unsolved[house]=0;
+		for(size_t number(1); number<=m_sudoku.sideLength(); ++number)
+			if(m_sudoku.candidatePositions(house, number))
+				++unsolved[house];
+	}
+	size_t maxDegree(0);
+	for(size_t f=fieldIndex; f<nbFields; f++) {
+		if(m_sudoku.isSolved(f) || m_sudoku.nbCandidates(f)!=minPossible)
+			continue;
+		size_t degree(0);
+		for(auto house : m_sudoku.housesOf(f))
+			degree += unsolved[house];
+		if(degree>maxDegree) {
+			maxDegree=degree;
+			fieldIndex=f;
+		}
+	}
+	return fieldIndex;
+}
 
-	if(m_settings.allowNakedSingle() || m_settings.allowNakedTuples()) {
-		// sole and unique candidates
-		workFields();
-		workRows();
-		workColumns();
-		workBlocks();
+bool SudokuSolver::selectPositions(size_t maxPositions, size_t & house, size_t & number) const {
+	size_t minPositions(maxPositions);
+	for(size_t h(0); h<m_sudoku.nbHouses(); ++h) {
+		for(size_t n(1); n<=m_sudoku.sideLength(); ++n) {
+			// no positions: n is placed in the house (or cannot be, which
+			// the field candidates will show)
+			size_t nbPositions(popCount(m_sudoku.candidatePositions(h, n)));
+			if(nbPositions==0 || nbPositions>=minPositions)
+				continue;
+			minPositions=nbPositions;
+			house=h;
+			number=n;
+			if(nbPositions==1)
+				return true;
+		}
 	}
+	return minPositions<maxPositions;
+}
 
-	if(m_sudoku.isSolved()) {
-		m_results.push_back(m_sudoku);
-		return Result::solved;
-	} else if(m_changed)
-		return Result::ambiguos;
+size_t SudokuSolver::takeGuess(
+		Sudoku const& board,
+		size_t fieldIndex,
+		size_t number,
+		Sudoku::CandidateMask & untried,
+		size_t & guessedNumber
+) {
+	if(number==0) {
+		guessedNumber=takeCandidate(board, fieldIndex, untried);
+		return fieldIndex;
+	}
+	// the positions of number in the house fieldIndex, in order
+	size_t k(lowestBit(untried));
+	untried &= untried-1;
+	guessedNumber=number;
+	return board.houseField(fieldIndex, k);
+}
 
-	if(m_settings.allowBlockBlock() || m_settings.allowBlockRowColumn()) {
-		checkInteractions();
-		if(m_settings.nextIterOnChange() && m_changed)
-			return Result::ambiguos;
+bool SudokuSolver::nextGuess() {
+	if(m_nbFrames==0)
+		return false;
+	SearchFrame & frame(m_frames[m_nbFrames-1]);
+	size_t number;
+	size_t fieldIndex(takeGuess(frame.sudoku, frame.fieldIndex, frame.number, frame.untried, number));
+	if(frame.untried) {
+		m_sudoku = frame.sudoku;
+		++m_stats.search.boardCopies;
+	} else {
+		// last alternative: the board is not needed anymore, the frame
+		// keeps the storage of the current one instead
+		std::swap(m_sudoku, frame.sudoku);
+		--m_nbFrames;
 	}
+	m_coloringSteps = frame.coloringSteps;
+	m_xyWingSteps = frame.xyWingSteps;
+	m_xyChainSteps = frame.xyChainSteps;
+	// the versions of the restored board may repeat those of the
+	// abandoned branch, so nothing derived from them can be trusted
+	invalidateDerived();
+	m_sudoku.enterSolution(fieldIndex, number, true);
+	return true;
+}
 
-	if(m_settings.allowNakedTuples() || m_settings.allowHiddenTuples()) {
-		checkTuples();
-		if(m_settings.nextIterOnChange() && m_changed)
-			return Result::ambiguos;
+size_t SudokuSolver::takeCandidate(
+		Sudoku const& board,
+		size_t fieldIndex,
+		Sudoku::CandidateMask & untried
+) {
+	// ascending order, skipping a random number of candidates, or the
+	// candidate that the fewest other fields of its houses share
+	Sudoku::CandidateMask rest(untried);
+	if(m_settings.guessMode()==GuessMode::Random) {
+		size_t skip(std::uniform_int_distribution<size_t>(0, popCount(untried)-1)(m_randomEngine));
+		for(; skip>0; --skip)
+			rest &= rest-1;
+	} else if(m_settings.leastConstrainingValue() && (rest & (rest-1))) {
+		auto houses(board.housesOf(fieldIndex));
+		size_t minShared(std::numeric_limits<size_t>::max());
+		for(Sudoku::CandidateMask m(untried); m; m &= m-1) {
+			size_t number(lowestBit(m)+1);
+			size_t shared(0);
+			for(auto house : houses)
+				shared += popCount(board.candidatePositions(house, number));
+			if(shared<minShared) {
+				minShared=shared;
+				rest=m;
+			}
+		}
 	}
+	size_t index(lowestBit(rest));
+	untried &= ~(Sudoku::CandidateMask(1) << index);
+	return index+1;
+}
 
-	return Result::ambiguos;
+namespace {
+
+// the i-th term (from 1) of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ...
+size_t luby(size_t i) {
+	while(true) {
+		// the smallest k with i <= 2^k-1
+		size_t k(1);
+		while((size_t(1) << k)-1 < i)
+			++k;
+		if(i==(size_t(1) << k)-1)
+			return size_t(1) << (k-1);
+		i -= (size_t(1) << (k-1))-1;
+	}
 }
 
-void SudokuSolver::workFields() {
-	size_t nbFields=m_sudoku.nbFields();
-	for(size_t field=0; field<nbFields; field++)
-		if(!m_sudoku.isSolved(field)) workField(field);
+} // namespace
+
+bool SudokuSolver::restartDue() const {
+	// after a solution, a restart could only find it again
+	if(!m_canRestart || !m_results.empty())
+		return false;
+	size_t limit(m_settings.restartBacktracks()*luby(m_nbRestarts+1));
+	return m_stats.search.backtracks-m_restartBacktracks >= limit;
 }
 
-void SudokuSolver::workRows()
-{
-	Sudoku::FieldGroup group(m_sudoku.sideLength());
-	for(size_t i=0; i<m_sudoku.sideLength(); i++) {
-		m_sudoku.getRow(i*m_sudoku.sideLength(), group);
-		workGroup(group);
+void SudokuSolver::restart() {
+	// the Luby sequence grows without bound, so some run eventually gets
+	// enough backtracks to search the whole tree and the search stays
+	// complete: a run that exhausts its stack proves there is no solution
+	m_nbFrames = 0;
+	m_sudoku = m_restartPoint.sudoku;
+	m_coloringSteps = m_restartPoint.coloringSteps;
+	m_xyWingSteps = m_restartPoint.xyWingSteps;
+	m_xyChainSteps = m_restartPoint.xyChainSteps;
+	invalidateDerived();
+	++m_nbRestarts;
+	m_restartBacktracks = m_stats.search.backtracks;
+	++m_stats.search.restarts;
+	++m_stats.search.boardCopies;
+}
+
+void SudokuSolver::invalidateDerived() {
+	for(auto & strategy : m_strategies)
+		strategy.idleVersion = std::numeric_limits<size_t>::max();
+	m_links.invalidate();
+}
+
+void SudokuSolver::registerStrategies() {
+	if(m_settings.allowNakedSingle())
+		addStrategy(Technique::nakedSingle, 1, &SudokuSolver::workFields);
+	if(m_settings.allowHiddenSingle())
+		addStrategy(Technique::hiddenSingle, 2, &SudokuSolver::workHouses);
+	if(m_settings.allowBlockBlock() || m_settings.allowBlockRowColumn())
+		addStrategy(Technique::interactions, 4, &SudokuSolver::checkInteractions);
+	if(m_settings.allowNakedTuples() || m_settings.allowHiddenTuples())
+		addStrategy(Technique::tuples, 8, &SudokuSolver::checkTuples);
+	if(m_settings.allowFish())
+		addStrategy(Technique::fish, 16, &SudokuSolver::checkFish);
+	if(m_settings.allowSimpleColoring())
+		addStrategy(Technique::simpleColoring, 16, &SudokuSolver::checkSimpleColoring);
+	if(m_settings.allowXYWing())
+		addStrategy(Technique::xyWing, 24, &SudokuSolver::checkXYWings);
+	if(m_settings.allowXYChain())
+		addStrategy(Technique::xyChain, 64, &SudokuSolver::checkXYChains);
+	if(m_settings.allowProbing())
+		addStrategy(Technique::probing, 128, &SudokuSolver::checkProbes);
+}
+
+void SudokuSolver::reserveScratch() {
+	// sized for the worst case, so that the propagation loop does not allocate
+	if(m_settings.allowProbing()) {
+		m_probe = m_sudoku;
+		m_probe.setTrail(&m_trail);
+		m_probe.setTrail(nullptr);
 	}
+	if(!m_settings.allowSimpleColoring() && !m_settings.allowXYWing() && !m_settings.allowXYChain())
+		return;
+	size_t nbFields(m_sudoku.nbFields());
+	m_links.reserve(m_sudoku);
+	m_colors.reserve(nbFields);
+	m_queue.reserve(nbFields);
+	m_seen.reserve(nbFields+1);
+	m_visited.reserve(nbFields);
 }
 
-void SudokuSolver::workColumns()
-{
-	Sudoku::FieldGroup group(m_sudoku.sideLength());
-	for(size_t i=0; i<m_sudoku.sideLength(); i++) {
-		m_sudoku.getColumn(i, group);
-		workGroup(group);
+void SudokuSolver::addStrategy(
+		Technique technique,
+		size_t cost,
+		void (SudokuSolver::*apply)()
+) {
+	Strategy strategy{technique, cost, apply, std::numeric_limits<size_t>::max()};
+	auto pos(std::upper_bound(m_strategies.begin(), m_strategies.end(), strategy,
+			[](Strategy const& s1, Strategy const& s2) {return s1.cost<s2.cost;}));
+	m_strategies.insert(pos, strategy);
+}
+
+SudokuSolver::Result SudokuSolver::solveIteration() {
+
+	m_changed = false;
+
+	for(auto & strategy : m_strategies) {
+		if(m_sudoku.isSolved()) break;
+		// nothing changed since it last came up empty
+		if(strategy.idleVersion==m_sudoku.version()) continue;
+
+		size_t version(m_sudoku.version());
+		size_t nbCandidates(m_sudoku.totalCandidates());
+		size_t nbSolved(m_sudoku.nbSolved());
+		auto start(std::chrono::steady_clock::now());
+
+		(this->*strategy.apply)();
+
+		SolverStats::TechniqueStats& stats(m_stats[strategy.technique]);
+		stats.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now()-start).count();
+		++stats.invocations;
+		stats.eliminations += nbCandidates-m_sudoku.totalCandidates();
+		stats.placements += m_sudoku.nbSolved()-nbSolved;
+
+		if(m_sudoku.version()==version) {
+			strategy.idleVersion=version;
+			continue;
+		}
+		m_changed = true;
+		if(m_settings.nextIterOnChange())
+			break;
 	}
+
+	return m_sudoku.isSolved() ? Result::solved : Result::ambiguos;
+}
+
+void SudokuSolver::workFields() {
+	size_t nbFields=m_sudoku.nbFields();
+	for(size_t field=0; field<nbFields; field++)
+		if(!m_sudoku.isSolved(field)) workField(field);
 }
 
-void SudokuSolver::workBlocks()
+void SudokuSolver::workHouses()
 {
-	Sudoku::FieldGroup group(m_sudoku.sideLength());
-	GridPoint p;
-	for(p.x=0; p.x<m_sudoku.sideLength(); p.x+=m_sudoku.blockWidth()) {
-		for(p.y=0; p.y<m_sudoku.sideLength(); p.y+=m_sudoku.blockHeight()) {
-			workGroup(group);
+	size_t sideLength(m_sudoku.sideLength());
+	for(size_t house(0); house<m_sudoku.nbHouses(); ++house) {
+		for(size_t number(1); number<=sideLength; ++number) {
+			// solved fields have no candidates, so a single position
+			// means the number is not yet solved in the house
+			Sudoku::CandidateMask positions(m_sudoku.candidatePositions(house, number));
+			if(popCount(positions)!=1) continue;
+			m_sudoku.enterSolution(m_sudoku.houseField(house, lowestBit(positions)), number);
+			m_changed = true;
 		}
 	}
 }
@@ -127,332 +561,551 @@ void SudokuSolver::workBlocks()
 void SudokuSolver::workField(size_t fieldIndex)
 {
 	if(m_sudoku.nbCandidates(fieldIndex)!=1) return;
-	std::vector<size_t> candidates;
-	m_sudoku.getCandidates(fieldIndex, candidates);
-	m_sudoku.enterSolution(fieldIndex, candidates[0]);
+	m_sudoku.enterSolution(fieldIndex, lowestBit(m_sudoku.candidateMask(fieldIndex))+1);
 	m_changed = true;
 }
 
-void SudokuSolver::workGroup(const Sudoku::FieldGroup& group)
-{
-	// loop all numbers
-	for(size_t i=1; i<=m_sudoku.sideLength(); i++) {
-		size_t fieldIndex;
-		size_t nbPossible(0);
-		for(auto field : group) {
-			if(m_sudoku.getSolution(field)==i) {
-				// the number is alredy solved in the group
-				nbPossible=0;
-				break;
-			}
-			if(m_sudoku.isCandidate(field, i)) {
-				if(++nbPossible>1) break;
-				fieldIndex=field;
-			}
-		}
-		// if there is only one possibility to palace the number
-		// we can safely enter it as the solution
-		if(nbPossible==1) {
-			m_sudoku.enterSolution(fieldIndex, i);
-			m_changed = true;
+void SudokuSolver::checkInteractions() {
+	BlockLines lines;
+	for(size_t number(1); number<=m_sudoku.sideLength(); number++) {
+		findBlockLines(number, lines);
+
+		// now check and eliminated candidate pairs
+		if(m_settings.allowBlockRowColumn()) {
+			checkBlockRowColInteractions(number, lines);
+			checkRowColBlockInteractions(number);
 		}
+
+		if(m_settings.allowBlockBlock())
+			checkBlockBlockInteractions(number, lines);
 	}
 }
 
-void SudokuSolver::findPossibleRowsAndColumns(InteractionStorage & interactions) {
-	interactions.clear();
-	interactions.resize(m_sudoku.sideLength());
-	size_t i(0);
-	for(GridPoint p(0,0); p.x<m_sudoku.sideLength(); p.x+=m_sudoku.blockWidth()) {
-		for(p.y=0; p.y<m_sudoku.sideLength(); p.y+=m_sudoku.blockHeight(),++i) {
-			interactions[i].fields.resize(m_sudoku.sideLength());
-			m_sudoku.getBlock(p, interactions[i].fields);
-			findPossibleRowsAndColumns(interactions[i]);
+void SudokuSolver::findBlockLines(size_t number, BlockLines & lines) const {
+	size_t blockWidth(m_sudoku.blockWidth());
+	size_t blockHeight(m_sudoku.blockHeight());
+	Sudoku::CandidateMask lineMask((Sudoku::CandidateMask(1) << blockHeight)-1);
+	for(size_t block(0); block<m_sudoku.sideLength(); ++block) {
+		// bit xi*blockHeight+yi is set if the number is possible at (xi,yi)
+		Sudoku::CandidateMask positions(
+				m_sudoku.candidatePositions(m_sudoku.blockHouse(block), number));
+		lines.rows[block]=0;
+		lines.columns[block]=0;
+		for(size_t x(0); x<blockWidth; ++x, positions >>= blockHeight) {
+			Sudoku::CandidateMask column(positions & lineMask);
+			lines.rows[block] |= column;
+			if(column)
+				lines.columns[block] |= Sudoku::CandidateMask(1) << x;
 		}
 	}
 }
 
-void SudokuSolver::checkInteractions() {
-	InteractionStorage blockInfo;
-	findPossibleRowsAndColumns(blockInfo);
+Sudoku::CandidateMask SudokuSolver::blockColumnPositions(size_t blockColumn) const {
+	size_t blockWidth(m_sudoku.blockWidth());
+	return ((Sudoku::CandidateMask(1) << blockWidth)-1) << (blockColumn*blockWidth);
+}
 
-	// now check and eliminated candidate pairs
-	if(m_settings.allowBlockRowColumn()) {
-//		std::cout << "CHECKING BLOCK-ROW/COLUMN\n";
-		checkBlockRowColInteractions(blockInfo);
-	}
+Sudoku::CandidateMask SudokuSolver::blockRowPositions(size_t blockRow) const {
+	size_t blockHeight(m_sudoku.blockHeight());
+	return ((Sudoku::CandidateMask(1) << blockHeight)-1) << (blockRow*blockHeight);
+}
 
-	if(m_settings.allowBlockBlock()) {
-//		std::cout << "CHECKING BLOCK-BLOCK\n";
-		checkBlockBlockInteractions(blockInfo);
-	}
+void SudokuSolver::eliminate(size_t house, size_t number, Sudoku::CandidateMask positions) {
+	if(positions==0) return;
+	for(; positions; positions &= positions-1)
+		m_sudoku.makeImpossible(m_sudoku.houseField(house, lowestBit(positions)), number);
+	m_changed = true;
 }
 
-void SudokuSolver::findPossibleRowsAndColumns(InteractionBlock & block) {
-	m_sudoku.getMissingNumbers(block.fields,block.missingNumbers);
-	block.possibleCols.clear();
-	block.possibleCols.resize(m_sudoku.sideLength());
-	block.possibleRows.clear();
-	block.possibleRows.resize(m_sudoku.sideLength());
-	block.referenceField.clear();
-	block.referenceField.resize(m_sudoku.sideLength());
-	for(auto number : block.missingNumbers) {
-		for(auto fieldIndex : block.fields) {
-			GridPoint p(m_sudoku.indexToXY(fieldIndex));
-			if(m_sudoku.isSolved(fieldIndex))
-				continue;
-			if(m_sudoku.isCandidate(fieldIndex, number)) {
-				size_t index(number-1);
-				block.possibleCols[index].insert(p.x);
-				block.possibleRows[index].insert(p.y);
-				block.referenceField[index]=fieldIndex;
-			}
+void SudokuSolver::checkBlockRowColInteractions(size_t number, BlockLines const& lines) {
+	size_t nbBlockRows(m_sudoku.nbBlockRows());
+	for(size_t block(0); block<m_sudoku.sideLength(); ++block) {
+		size_t blockColumn(block/nbBlockRows), blockRow(block%nbBlockRows);
+		if(popCount(lines.rows[block])==1) {
+			size_t house(m_sudoku.rowHouse(
+					blockRow*m_sudoku.blockHeight()+lowestBit(lines.rows[block])));
+			eliminate(house, number, m_sudoku.candidatePositions(house, number)
+					& ~blockColumnPositions(blockColumn));
+		}
+		if(popCount(lines.columns[block])==1) {
+			size_t house(m_sudoku.columnHouse(
+					blockColumn*m_sudoku.blockWidth()+lowestBit(lines.columns[block])));
+			eliminate(house, number, m_sudoku.candidatePositions(house, number)
+					& ~blockRowPositions(blockRow));
 		}
 	}
 }
 
-void SudokuSolver::checkBlockRowColInteractions(InteractionStorage const& blockInfo) {
-	for(auto const& block : blockInfo) {
-		for(auto number : block.missingNumbers) {
-			size_t index(number-1);
-			if(block.possibleRows[index].size()==1)
-				applyBlockRowColInteractions(block.fields, block.referenceField[index], number, true);
-			if(block.possibleCols[index].size()==1)
-				applyBlockRowColInteractions(block.fields, block.referenceField[index], number, false);
-		}
+void SudokuSolver::checkRowColBlockInteractions(size_t number) {
+	size_t sideLength(m_sudoku.sideLength());
+	size_t blockWidth(m_sudoku.blockWidth());
+	size_t blockHeight(m_sudoku.blockHeight());
+	size_t nbBlockRows(m_sudoku.nbBlockRows());
+
+	// positions of one row/column of fields within a block
+	Sudoku::CandidateMask blockColumn((Sudoku::CandidateMask(1) << blockHeight)-1);
+	Sudoku::CandidateMask blockRow(0);
+	for(size_t x(0); x<blockWidth; ++x)
+		blockRow |= Sudoku::CandidateMask(1) << (x*blockHeight);
+
+	for(size_t y(0); y<sideLength; ++y) {
+		Sudoku::CandidateMask positions(
+				m_sudoku.candidatePositions(m_sudoku.rowHouse(y), number));
+		if(positions==0) continue;
+		size_t bx(lowestBit(positions)/blockWidth);
+		if(positions & ~blockColumnPositions(bx)) continue;
+		size_t house(m_sudoku.blockHouse(bx*nbBlockRows + y/blockHeight));
+		eliminate(house, number, m_sudoku.candidatePositions(house, number)
+				& ~(blockRow << (y%blockHeight)));
 	}
-}
 
-void SudokuSolver::applyBlockRowColInteractions(
-		Sudoku::FieldGroup const& origGroup,
-		size_t refFieldIndex,
-		size_t number,
-		bool row
-) {
-	Sudoku::FieldGroup group;
-	if(row)
-		m_sudoku.getRow(refFieldIndex,group);
-	else
-		m_sudoku.getColumn(refFieldIndex,group);
-	for(auto fieldIndex : group) {
-		if(m_sudoku.isSolved(fieldIndex)) continue;
-		if(!m_sudoku.isCandidate(fieldIndex,number)) continue;
-		if(contains(origGroup, fieldIndex)) continue;
-		m_changed = true;
-		m_sudoku.makeImpossible(fieldIndex, number);
+	for(size_t x(0); x<sideLength; ++x) {
+		Sudoku::CandidateMask positions(
+				m_sudoku.candidatePositions(m_sudoku.columnHouse(x), number));
+		if(positions==0) continue;
+		size_t by(lowestBit(positions)/blockHeight);
+		if(positions & ~blockRowPositions(by)) continue;
+		size_t house(m_sudoku.blockHouse((x/blockWidth)*nbBlockRows + by));
+		eliminate(house, number, m_sudoku.candidatePositions(house, number)
+				& ~(blockColumn << ((x%blockWidth)*blockHeight)));
 	}
 }
 
-void SudokuSolver::checkBlockBlockInteractions(InteractionStorage const& blockInfo) {
-	for(size_t number(1); number<=m_sudoku.sideLength(); number++) {
-		size_t index(number-1);
-		for(size_t b1(0); b1<blockInfo.size(); b1++) {
-			if(blockInfo[b1].possibleCols[index].size()==2) {
-				// compare with blocks below this one in the same column
-				size_t b2max(m_sudoku.nbBlockRows()*(1+b1/m_sudoku.nbBlockRows()));
-				for(size_t b2(b1+1); b2<b2max; b2++) {
-					if(blockInfo[b1].possibleCols[index].size()!=2) continue;
-					if(blockInfo[b1].possibleCols[index]!=blockInfo[b2].possibleCols[index]) continue;
-					applyBlockBlockInteractions(
-							blockInfo[b1],
-							blockInfo[b2],
-							blockInfo[b1].possibleCols[index],
-							number,
-							false);
+void SudokuSolver::checkBlockBlockInteractions(size_t number, BlockLines const& lines) {
+	size_t nbBlocks(m_sudoku.sideLength());
+	size_t nbBlockRows(m_sudoku.nbBlockRows());
+	for(size_t b1(0); b1<nbBlocks; b1++) {
+		size_t bx1(b1/nbBlockRows), by1(b1%nbBlockRows);
+		if(popCount(lines.columns[b1])==2) {
+			// compare with blocks below this one in the same column
+			size_t b2max(nbBlockRows*(1+bx1));
+			for(size_t b2(b1+1); b2<b2max; b2++) {
+				if(lines.columns[b1]!=lines.columns[b2]) continue;
+				Sudoku::CandidateMask keep(blockRowPositions(by1) | blockRowPositions(b2%nbBlockRows));
+				for(Sudoku::CandidateMask c(lines.columns[b1]); c; c &= c-1) {
+					size_t house(m_sudoku.columnHouse(bx1*m_sudoku.blockWidth()+lowestBit(c)));
+					eliminate(house, number, m_sudoku.candidatePositions(house, number) & ~keep);
 				}
 			}
-			if(blockInfo[b1].possibleRows[index].size()==2) {
-				// compare with blocks right of this one in the same row
-				for(size_t b2(b1+m_sudoku.nbBlockColumns()); b2<blockInfo.size(); b2+=m_sudoku.nbBlockColumns()) {
-					if(blockInfo[b1].possibleRows[index].size()!=2) continue;
-					if(blockInfo[b1].possibleRows[index]!=blockInfo[b2].possibleRows[index]) continue;
-					applyBlockBlockInteractions(
-							blockInfo[b1],
-							blockInfo[b2],
-							blockInfo[b1].possibleRows[index],
-							number,
-							true);
+		}
+		if(popCount(lines.rows[b1])==2) {
+			// compare with blocks right of this one in the same row
+			for(size_t b2(b1+nbBlockRows); b2<nbBlocks; b2+=nbBlockRows) {
+				if(lines.rows[b1]!=lines.rows[b2]) continue;
+				Sudoku::CandidateMask keep(blockColumnPositions(bx1) | blockColumnPositions(b2/nbBlockRows));
+				for(Sudoku::CandidateMask r(lines.rows[b1]); r; r &= r-1) {
+					size_t house(m_sudoku.rowHouse(by1*m_sudoku.blockHeight()+lowestBit(r)));
+					eliminate(house, number, m_sudoku.candidatePositions(house, number) & ~keep);
 				}
 			}
 		}
 	}
 }
 
-void SudokuSolver::applyBlockBlockInteractions(
-		InteractionBlock const& block1,
-		InteractionBlock const& block2,
-		std::set<size_t> const& rowOrColumnIndices,
-		size_t number,
-		bool row
-) {
-	for(size_t index : rowOrColumnIndices) {
-		Sudoku::FieldGroup group;
-		if(row)
-			m_sudoku.getRow(GridPoint(0,index), group);
-		else
-			m_sudoku.getColumn(GridPoint(index,0), group);
-		for(size_t fieldIndex : group) {
-			if(m_sudoku.isSolved(fieldIndex)) continue;
-			if(!m_sudoku.isCandidate(fieldIndex, number)) continue;
-			if(contains(block1.fields,fieldIndex)) continue;
-			if(contains(block2.fields,fieldIndex)) continue;
-			m_changed = true;
-			m_sudoku.makeImpossible(fieldIndex, number);
+void SudokuSolver::checkTuples() {
+	HouseCandidates info;
+	size_t nbHouses(m_sudoku.nbHouses());
+	for(size_t tupleSize(2); tupleSize<=m_settings.maxTupleSize(); ++tupleSize) {
+		for(size_t house(0); house<nbHouses; ++house) {
+			getHouseCandidates(house, info);
+			// a tuple spanning all unsolved fields tells us nothing
+			if(tupleSize>=info.nbUnsolved) continue;
+			if(m_settings.allowNakedTuples()) {
+				while(checkNakedTuples(info, tupleSize, 0, 0, 0, 0))
+					getHouseCandidates(house, info);
+			}
+			if(m_settings.allowHiddenTuples()) {
+				while(checkHiddenTuples(info, tupleSize, 0, 0, 0, 0))
+					getHouseCandidates(house, info);
+			}
 		}
 	}
 }
 
-void SudokuSolver::checkTuples() {
-	for(size_t tupleSize(1); tupleSize<m_settings.maxTupleSize(); ++tupleSize)
-		checkTuples(tupleSize);
+void SudokuSolver::getHouseCandidates(size_t house, HouseCandidates& info) const {
+	size_t sideLength(m_sudoku.sideLength());
+	info.nbFields=sideLength;
+	info.nbUnsolved=0;
+	info.missingNumbers=m_sudoku.allCandidates();
+	for(size_t k(0); k<sideLength; ++k) {
+		size_t fieldIndex(m_sudoku.houseField(house, k));
+		info.fields[k] = fieldIndex;
+		info.candidates[k] = m_sudoku.candidateMask(fieldIndex);
+		info.positions[k] = m_sudoku.candidatePositions(house, k+1);
+		if(m_sudoku.isSolved(fieldIndex))
+			info.missingNumbers &= ~(Sudoku::CandidateMask(1) << (m_sudoku.getSolution(fieldIndex)-1));
+		else
+			++info.nbUnsolved;
+	}
 }
 
-void SudokuSolver::checkTuples(
-		size_t nbTupleElements
-){
-	// find all candidate tuples with correct number of elements
-	TupleLookup tuples;
-	size_t nbFields=m_sudoku.nbFields();
-	for(size_t fieldIndex(0); fieldIndex<nbFields; fieldIndex++) {
-		if(m_sudoku.nbCandidates(fieldIndex)!=nbTupleElements) continue;
-
-		CandidateList candidates;
-		m_sudoku.getCandidates(fieldIndex, candidates);
-		tuples[std::move(candidates)].push_back(fieldIndex);
+bool SudokuSolver::checkNakedTuples(
+		HouseCandidates const& info,
+		size_t tupleSize,
+		size_t firstField,
+		size_t nbChosen,
+		Sudoku::CandidateMask chosenFields,
+		Sudoku::CandidateMask numbers
+) {
+	if(nbChosen==tupleSize) {
+		// We've got a match!
+		bool changed(false);
+		for(size_t k(0); k<info.nbFields; ++k) {
+			if(chosenFields & (Sudoku::CandidateMask(1) << k)) continue;
+			Sudoku::CandidateMask remove(info.candidates[k] & numbers);
+			for(; remove; remove &= remove-1)
+				m_sudoku.makeImpossible(info.fields[k], lowestBit(remove)+1);
+			changed |= (info.candidates[k] & numbers)!=0;
+		}
+		m_changed |= changed;
+		return changed;
 	}
+	for(size_t k(firstField); k+tupleSize-nbChosen<=info.nbFields; ++k) {
+		if(info.candidates[k]==0) continue;
+		Sudoku::CandidateMask merged(numbers | info.candidates[k]);
+		if(popCount(merged)>tupleSize) continue;
+		if(checkNakedTuples(info, tupleSize, k+1, nbChosen+1,
+				chosenFields | (Sudoku::CandidateMask(1) << k), merged))
+			return true;
+	}
+	return false;
+}
 
-	for(TupleLookup::const_iterator it=tuples.begin(); it!=tuples.end(); ++it) {
-		// we need at least N fields with an identical N-tuple to make any decision
-		if(it->second.size() < it->first.size()) continue;
-		for(size_t i(0); i<it->second.size(); ++i) {
+bool SudokuSolver::checkHiddenTuples(
+		HouseCandidates const& info,
+		size_t tupleSize,
+		size_t firstNumber,
+		size_t nbChosen,
+		Sudoku::CandidateMask chosenNumbers,
+		Sudoku::CandidateMask fields
+) {
+	if(nbChosen==tupleSize) {
+		// We've got a match!
+		bool changed(false);
+		for(Sudoku::CandidateMask f(fields); f; f &= f-1) {
+			size_t k(lowestBit(f));
+			Sudoku::CandidateMask remove(info.candidates[k] & ~chosenNumbers);
+			changed |= remove!=0;
+			for(; remove; remove &= remove-1)
+				m_sudoku.makeImpossible(info.fields[k], lowestBit(remove)+1);
+		}
+		m_changed |= changed;
+		return changed;
+	}
+	// shifting a mask by its full width is undefined
+	if(firstNumber>=info.nbFields)
+		return false;
+	Sudoku::CandidateMask remaining(info.missingNumbers >> firstNumber);
+	for(; remaining; remaining &= remaining-1) {
+		size_t index(firstNumber+lowestBit(remaining));
+		if(info.positions[index]==0) continue;
+		Sudoku::CandidateMask merged(fields | info.positions[index]);
+		if(popCount(merged)>tupleSize) continue;
+		if(checkHiddenTuples(info, tupleSize, index+1, nbChosen+1,
+				chosenNumbers | (Sudoku::CandidateMask(1) << index), merged))
+			return true;
+	}
+	return false;
+}
 
-			FieldList tupleIndices({i});
-			Sudoku::FieldGroup group(m_sudoku.sideLength());
+void SudokuSolver::checkFish() {
+	size_t sideLength(m_sudoku.sideLength());
+	std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> baseSets;
+	for(size_t number(1); number<=sideLength; ++number) {
+		for(bool rows : {true, false}) {
+			// base sets are rows (columns), cover sets are columns (rows)
+			size_t nbBases(findFishBases(number, rows, baseSets));
+			// a fish spanning all bases covers all candidates and tells us nothing
+			for(size_t fishSize(2); fishSize<=m_settings.maxFishSize() && fishSize<nbBases; ++fishSize) {
+				while(checkFish(number, rows, baseSets, fishSize, 0, 0, 0, 0))
+					nbBases=findFishBases(number, rows, baseSets);
+			}
+		}
+	}
+}
 
-			m_sudoku.getRow(it->second[i], group);
-			checkTuples(it,tupleIndices,group);
+size_t SudokuSolver::findFishBases(
+		size_t number,
+		bool rows,
+		std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> & baseSets
+) const {
+	size_t nbBases(0);
+	for(size_t i(0); i<m_sudoku.sideLength(); ++i) {
+		baseSets[i] = m_sudoku.candidatePositions(
+				rows ? m_sudoku.rowHouse(i) : m_sudoku.columnHouse(i), number);
+		if(baseSets[i]) ++nbBases;
+	}
+	return nbBases;
+}
 
-			m_sudoku.getColumn(it->second[i], group);
-			checkTuples(it,tupleIndices,group);
+bool SudokuSolver::checkFish(
+		size_t number,
+		bool rows,
+		std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> const& baseSets,
+		size_t fishSize,
+		size_t firstBase,
+		size_t nbChosen,
+		Sudoku::CandidateMask chosenBases,
+		Sudoku::CandidateMask coverSets
+) {
+	if(nbChosen==fishSize) {
+		// We've got a fish!
+		bool changed(false);
+		for(Sudoku::CandidateMask c(coverSets); c; c &= c-1) {
+			size_t house(rows ?
+					m_sudoku.columnHouse(lowestBit(c)) : m_sudoku.rowHouse(lowestBit(c)));
+			Sudoku::CandidateMask remove(
+					m_sudoku.candidatePositions(house, number) & ~chosenBases);
+			changed |= remove!=0;
+			eliminate(house, number, remove);
+		}
+		return changed;
+	}
+	size_t sideLength(m_sudoku.sideLength());
+	for(size_t base(firstBase); base+fishSize-nbChosen<=sideLength; ++base) {
+		if(baseSets[base]==0) continue;
+		Sudoku::CandidateMask merged(coverSets | baseSets[base]);
+		if(popCount(merged)>fishSize) continue;
+		if(checkFish(number, rows, baseSets, fishSize, base+1, nbChosen+1,
+				chosenBases | (Sudoku::CandidateMask(1) << base), merged))
+			return true;
+	}
+	return false;
+}
 
-			m_sudoku.getBlock(it->second[i], group);
-			checkTuples(it,tupleIndices,group);
+void SudokuSolver::checkSimpleColoring() {
+	m_links.update(m_sudoku);
+	for(size_t number(1); number<=m_sudoku.sideLength(); ++number) {
+		if(m_coloringSteps>=m_settings.maxColoringSteps()) return;
+		if(m_links.nbStrongLinks(number)==0) continue;
+		if(checkSimpleColoring(number)) {
+			++m_coloringSteps;
+			m_changed = true;
 		}
 	}
 }
 
-void SudokuSolver::checkTuples(
-		TupleLookup::const_iterator tuple,
-		FieldList const& tupleIndices,
-		Sudoku::FieldGroup const& group)
-{
-	if(tupleIndices.size()>1 && ! contains(group, tuple->second[tupleIndices.back()])) {
-		return;
+bool SudokuSolver::checkSimpleColoring(size_t number) {
+	size_t nbFields(m_sudoku.nbFields());
+	// colors 2c+1 and 2c+2 belong to the connected component c, 0: uncolored
+	m_colors.assign(nbFields, 0);
+	size_t nbColors(0);
+	for(size_t f(0); f<nbFields; ++f) {
+		if(m_colors[f]!=0 || m_links.strongLinks(number, f).size()==0) continue;
+		m_colors[f]=++nbColors;
+		++nbColors;
+		m_queue.clear();
+		m_queue.push_back(f);
+		for(size_t q(0); q<m_queue.size(); ++q) {
+			size_t field(m_queue[q]);
+			// the partner of color 2c+1 is 2c+2 and vice versa
+			size_t opposite(m_colors[field]%2 ? m_colors[field]+1 : m_colors[field]-1);
+			for(auto linked : m_links.strongLinks(number, field)) {
+				if(m_colors[linked]!=0) continue;
+				m_colors[linked]=opposite;
+				m_queue.push_back(linked);
+			}
+		}
 	}
-	// we need at least N fields with an identical N-tuple to make any decision
-	if(tupleIndices.size()<tuple->first.size()) {
-		for(size_t tupleIndex(tupleIndices.back()+1); tupleIndex<tuple->second.size(); ++tupleIndex) {
-			FieldList newList(tupleIndices);
-			newList.push_back(tupleIndex);
-			checkTuples(tuple, newList, group);
+
+	// color wrap: two fields of the same color in one house
+	for(size_t house(0); house<m_sudoku.nbHouses(); ++house) {
+		Sudoku::CandidateMask positions(m_sudoku.candidatePositions(house, number));
+		for(Sudoku::CandidateMask p1(positions); p1; p1 &= p1-1) {
+			size_t color(m_colors[m_sudoku.houseField(house, lowestBit(p1))]);
+			if(color==0) continue;
+			for(Sudoku::CandidateMask p2(p1 & (p1-1)); p2; p2 &= p2-1) {
+				if(m_colors[m_sudoku.houseField(house, lowestBit(p2))]!=color) continue;
+				for(size_t f(0); f<nbFields; ++f)
+					if(m_colors[f]==color)
+						m_sudoku.makeImpossible(f, number);
+				return true;
+			}
 		}
-	} else {
-		// We've got a match!
-		FieldList tupleFields(tupleIndices.size());
-		for(size_t i(0); i<tupleIndices.size(); ++i) {
-			tupleFields[i]=tuple->second[tupleIndices[i]];
-		}
-		for(size_t fieldIndex : group) {
-			if(contains(tupleFields, fieldIndex)) continue;
-			std::vector<size_t> numbers;
-			m_sudoku.getCandidates(fieldIndex, numbers);
-			for(size_t number : numbers) {
-				if(! contains(tuple->first, number)) continue;
-				m_sudoku.makeImpossible(fieldIndex, number);
-				m_changed=true;
+	}
+
+	// color trap: a field seeing both colors of a component
+	// m_seen[color] is set to field+1 when the field sees that color
+	m_seen.assign(nbColors+1, 0);
+	bool changed(false);
+	for(size_t f(0); f<nbFields; ++f) {
+		if(m_colors[f]!=0 || !m_sudoku.isCandidate(f, number)) continue;
+		size_t const houses[3] = {
+				m_sudoku.rowHouse(m_sudoku.rowOf(f)),
+				m_sudoku.columnHouse(m_sudoku.columnOf(f)),
+				m_sudoku.blockHouse(m_sudoku.blockOf(f))};
+		bool trapped(false);
+		for(size_t h(0); h<3 && !trapped; ++h) {
+			for(Sudoku::CandidateMask p(m_sudoku.candidatePositions(houses[h], number)); p; p &= p-1) {
+				size_t color(m_colors[m_sudoku.houseField(houses[h], lowestBit(p))]);
+				if(color==0) continue;
+				m_seen[color]=f+1;
+				size_t opposite(color%2 ? color+1 : color-1);
+				if(m_seen[opposite]==f+1) {
+					trapped=true;
+					break;
+				}
 			}
 		}
+		if(trapped) {
+			m_sudoku.makeImpossible(f, number);
+			changed=true;
+		}
 	}
+	return changed;
 }
 
-void SudokuSolver::educatedGuess()
-{
-//	std::cout << "DETERMINISTIC GUESS\n";
-	// find field with minimum number of possibilities
-	size_t fieldIndex(999);
-	size_t minPossible(m_sudoku.sideLength()+1);
-	size_t nbFields=m_sudoku.nbFields();
-	for(size_t f=0; f<nbFields; f++) {
-		if(m_sudoku.isSolved(f))
-			continue;
-		if(m_sudoku.nbCandidates(f) < minPossible) {
-			minPossible=m_sudoku.nbCandidates(f);
-			fieldIndex=f;
+void SudokuSolver::checkXYWings() {
+	m_links.update(m_sudoku);
+	size_t nbFields(m_sudoku.nbFields());
+	for(size_t f(0); f<nbFields; ++f) {
+		if(m_xyWingSteps>=m_settings.maxXYWingSteps()) return;
+		size_t nbCandidates(m_sudoku.nbCandidates(f));
+		bool found(false);
+		if(nbCandidates==2)
+			found=checkXYWing(f);
+		else if(nbCandidates==3)
+			found=checkXYZWing(f);
+		if(found) {
+			++m_xyWingSteps;
+			m_changed = true;
+			// the bivalue fields may have changed
+			m_links.update(m_sudoku);
 		}
 	}
-	if(fieldIndex==999) {
-		throw std::runtime_error("SudokuSolver::educatedGuess min not found");
+}
+
+bool SudokuSolver::checkXYWing(size_t pivot) {
+	Sudoku::CandidateMask pivotMask(m_sudoku.candidateMask(pivot));
+	LinkGraph::Neighbours pincers(m_links.bivalueNeighbours(pivot));
+	for(size_t const* x(pincers.begin()); x!=pincers.end(); ++x) {
+		Sudoku::CandidateMask xMask(m_sudoku.candidateMask(*x));
+		if(popCount(xMask & pivotMask)!=1) continue;
+		for(size_t const* y(x+1); y!=pincers.end(); ++y) {
+			Sudoku::CandidateMask yMask(m_sudoku.candidateMask(*y));
+			if(popCount(yMask & pivotMask)!=1) continue;
+			// the pincers must use different numbers of the pivot ...
+			if((xMask & pivotMask)==(yMask & pivotMask)) continue;
+			// ... and share the same third number
+			Sudoku::CandidateMask common(xMask & yMask & ~pivotMask);
+			if(common==0) continue;
+			size_t const wing[2] = {*x, *y};
+			if(eliminateSeenByAll(lowestBit(common)+1, wing, 2))
+				return true;
+		}
 	}
-	// get the possiblities;
-	std::vector<size_t> numbers;
-	m_sudoku.getCandidates(fieldIndex, numbers);
-	for(auto i : numbers) {
-//		Sudoku tmp(m_sudoku);
-		SudokuSolver solver(*this);
-		solver.m_sudoku.enterSolution(fieldIndex, i, true);
-		if(solver.solve() == Result::solved) {
-			// move results from child solver
-			moveResults(solver);
-			if(m_results.size()>=m_settings.maxResults())
-				return;
+	return false;
+}
+
+bool SudokuSolver::checkXYZWing(size_t pivot) {
+	Sudoku::CandidateMask pivotMask(m_sudoku.candidateMask(pivot));
+	size_t const houses[3] = {
+			m_sudoku.rowHouse(m_sudoku.rowOf(pivot)),
+			m_sudoku.columnHouse(m_sudoku.columnOf(pivot)),
+			m_sudoku.blockHouse(m_sudoku.blockOf(pivot))};
+	// bivalue peers whose candidates are a subset of the pivot
+	std::array<size_t, 3*Sudoku::maxSideLength> pincers;
+	size_t nbPincers(0);
+	for(size_t h(0); h<3; ++h) {
+		for(size_t k(0); k<m_sudoku.sideLength(); ++k) {
+			size_t f(m_sudoku.houseField(houses[h], k));
+			Sudoku::CandidateMask mask(m_sudoku.candidateMask(f));
+			if(f==pivot || popCount(mask)!=2 || (mask & ~pivotMask)) continue;
+			if(std::find(pincers.begin(), pincers.begin()+nbPincers, f)!=pincers.begin()+nbPincers) continue;
+			pincers[nbPincers++]=f;
+		}
+	}
+	for(size_t x(0); x<nbPincers; ++x) {
+		Sudoku::CandidateMask xMask(m_sudoku.candidateMask(pincers[x]));
+		for(size_t y(x+1); y<nbPincers; ++y) {
+			Sudoku::CandidateMask yMask(m_sudoku.candidateMask(pincers[y]));
+			if(xMask==yMask) continue;
+			size_t const wing[3] = {pivot, pincers[x], pincers[y]};
+			if(eliminateSeenByAll(lowestBit(xMask & yMask)+1, wing, 3))
+				return true;
 		}
 	}
+	return false;
 }
 
-void SudokuSolver::randomGuess()
-{
-//	std::cout << "SudokuSolver::randomGuess " << m_depth << std::endl;
-	// check if the current sudoku is solvable at all
-	{
-		Settings newSettings(m_settings);
-		newSettings.guessMode(GuessMode::Deterministic);
-		SudokuSolver solver(newSettings,m_sudoku,m_depth);
-		if(solver.solve()==Result::impossible)
-			return;
-	}
-	// find fields with missing entries
-	size_t nbFields=m_sudoku.nbFields();
-	Sudoku::FieldGroup fields;
-	for(size_t f=0; f<nbFields; f++) {
-		if((!m_sudoku.isSolved(f)) && m_sudoku.nbCandidates(f)>0)
-			fields.push_back(f);
-	}
-    std::random_device r;
-    std::default_random_engine randEngine(r());
-    std::shuffle(fields.begin(),fields.end(),randEngine);
-    for(auto fieldIndex : fields) {
-    	std::vector<size_t> numbers;
-    	m_sudoku.getCandidates(fieldIndex, numbers);
-        std::shuffle(numbers.begin(),numbers.end(),randEngine);
-        for(auto nb : numbers) {
-			SudokuSolver solver(*this);
-			solver.m_sudoku.enterSolution(fieldIndex, nb, true);
-			Result res = solver.solve();
-			if(res == Result::solved) {
-				moveResults(solver);
-				if(m_results.size()>=m_settings.maxResults())
-					return;
+void SudokuSolver::checkXYChains() {
+	m_links.update(m_sudoku);
+	m_visited.assign(m_sudoku.nbFields(), 0);
+	for(size_t i(0); i<m_links.bivalueFields().size(); ++i) {
+		size_t start(m_links.bivalueFields()[i]);
+		Sudoku::CandidateMask mask(m_sudoku.candidateMask(start));
+		// a previous chain may have removed candidates from this field
+		if(popCount(mask)!=2) continue;
+		for(Sudoku::CandidateMask m(mask); m; m &= m-1) {
+			if(m_xyChainSteps>=m_settings.maxXYChainSteps()) return;
+			size_t number(lowestBit(m)+1);
+			// if start is not number, it must be the other candidate
+			size_t forced(lowestBit(mask & ~(Sudoku::CandidateMask(1) << (number-1)))+1);
+			m_visited[start]=1;
+			bool found(checkXYChain(start, number, start, forced, 1));
+			m_visited[start]=0;
+			if(found) {
+				++m_xyChainSteps;
+				m_changed = true;
+				m_links.update(m_sudoku);
+				m_visited.assign(m_sudoku.nbFields(), 0);
+				break;
 			}
-        }
-    }
+		}
+	}
 }
 
-void SudokuSolver::moveResults(SudokuSolver & other)
-{
-	m_results.insert(
-			m_results.end(),
-			std::make_move_iterator(other.m_results.begin()),
-			std::make_move_iterator(other.m_results.end()));
+bool SudokuSolver::checkXYChain(
+		size_t start,
+		size_t number,
+		size_t fieldIndex,
+		size_t forcedNumber,
+		size_t length
+) {
+	// fieldIndex must be forcedNumber, so the next field must not be forcedNumber
+	for(auto next : m_links.bivalueNeighbours(fieldIndex)) {
+		if(m_visited[next] || !m_sudoku.isCandidate(next, forcedNumber)) continue;
+		Sudoku::CandidateMask mask(m_sudoku.candidateMask(next));
+		if(popCount(mask)!=2) continue;
+		size_t other(lowestBit(mask & ~(Sudoku::CandidateMask(1) << (forcedNumber-1)))+1);
+		if(other==number) {
+			size_t const ends[2] = {start, next};
+			if(eliminateSeenByAll(number, ends, 2))
+				return true;
+		}
+		if(length+1<m_settings.maxXYChainLength()) {
+			m_visited[next]=1;
+			bool found(checkXYChain(start, number, next, other, length+1));
+			m_visited[next]=0;
+			if(found) return true;
+		}
+	}
+	return false;
+}
+
+bool SudokuSolver::eliminateSeenByAll(
+		size_t number,
+		size_t const* fields,
+		size_t nbFields
+) {
+	// all candidates seeing fields[0] are in one of its houses
+	size_t const houses[3] = {
+			m_sudoku.rowHouse(m_sudoku.rowOf(fields[0])),
+			m_sudoku.columnHouse(m_sudoku.columnOf(fields[0])),
+			m_sudoku.blockHouse(m_sudoku.blockOf(fields[0]))};
+	bool changed(false);
+	for(size_t h(0); h<3; ++h) {
+		for(Sudoku::CandidateMask p(m_sudoku.candidatePositions(houses[h], number)); p; p &= p-1) {
+			size_t f(m_sudoku.houseField(houses[h], lowestBit(p)));
+			bool seesAll(true);
+			for(size_t i(0); i<nbFields && seesAll; ++i)
+				seesAll = m_sudoku.arePeers(f, fields[i]);
+			if(!seesAll) continue;
+			m_sudoku.makeImpossible(f, number);
+			changed=true;
+		}
+	}
+	return changed;
 }
 
 std::ostream& operator << (std::ostream& os, const SudokuSolver::Result& res)
@@ -463,5 +1116,90 @@ std::ostream& operator << (std::ostream& os, const SudokuSolver::Result& res)
 		os << "impossible";
 	else if(res==SudokuSolver::Result::solved)
 		os << "solved";
+	else if(res==SudokuSolver::Result::timeout)
+		os << "timeout";
 	return os;
 }
+
+void SudokuSolver::checkProbes() {
+	size_t nbFields(m_sudoku.nbFields());
+	size_t nbProbes(0);
+	// copy-assignment keeps the storage of the probe board
+	m_probe = m_sudoku;
+	m_probe.setTrail(&m_trail);
+	// the fields with two candidates first, their failed probes place a number
+	for(size_t nbCandidates(2); nbCandidates<=m_sudoku.sideLength(); ++nbCandidates) {
+		for(size_t f(0); f<nbFields; ++f) {
+			if(m_sudoku.nbCandidates(f)!=nbCandidates)
+				continue;
+			for(Sudoku::CandidateMask m(m_sudoku.candidateMask(f)); m; m &= m-1) {
+				if(nbProbes>=m_settings.maxProbes()) {
+					m_probe.setTrail(nullptr);
+					return;
+				}
+				++nbProbes;
+				size_t number(lowestBit(m)+1);
+				m_probe.enterSolution(f, number);
+				bool consistent(probeSingles());
+				m_probe.undoTrail();
+				if(consistent)
+					continue;
+				m_sudoku.makeImpossible(f, number);
+				m_probe.setTrail(nullptr);
+				m_probe.makeImpossible(f, number);
+				m_probe.setTrail(&m_trail);
+				m_changed = true;
+			}
+			// all candidates failed, the board is contradictory
+			if(m_sudoku.nbCandidates(f)==0) {
+				m_probe.setTrail(nullptr);
+				return;
+			}
+		}
+	}
+	m_probe.setTrail(nullptr);
+}
+
+bool SudokuSolver::probeSingles() {
+	size_t nbFields(m_probe.nbFields());
+	size_t sideLength(m_probe.sideLength());
+	std::array<size_t, 3*Sudoku::maxSideLength> unsolved;
+	bool changed(true);
+	while(changed) {
+		changed = false;
+		std::fill(unsolved.begin(), unsolved.begin()+m_probe.nbHouses(), 0);
+		for(size_t f(0); f<nbFields; ++f) {
+			if(m_probe.isSolved(f))
+				continue;
+			size_t nbCandidates(m_probe.nbCandidates(f));
+			if(nbCandidates==0)
+				return false;
+			if(nbCandidates==1) {
+				m_probe.enterSolution(f, lowestBit(m_probe.candidateMask(f))+1);
+				changed = true;
+				continue;
+			}
+			for(auto house : m_probe.housesOf(f))
+				++unsolved[house];
+		}
+		if(changed)
+			continue;
+		for(size_t house(0); house<m_probe.nbHouses(); ++house) {
+			// every unsolved field of a house needs a number of its own
+			size_t nbNumbers(0);
+			for(size_t number(1); number<=sideLength; ++number) {
+				Sudoku::CandidateMask positions(m_probe.candidatePositions(house, number));
+				if(!positions)
+					continue;
+				++nbNumbers;
+				if(positions & (positions-1))
+					continue;
+				m_probe.enterSolution(m_probe.houseField(house, lowestBit(positions)), number);
+				changed = true;
+			}
+			if(!changed && nbNumbers<unsolved[house])
+				return false;
+		}
+	}
+	return true;
+}
@@ -1,9 +1,13 @@
 #include "Sudoku.h"
+#include "LinkGraph.h"
+#include "SolverStats.h"
+#include "CancellationToken.h"
 #include "DataContainerMacro.h"
-#include <memory>
+#include "RandomEngine.h"
 #include <deque>
 #include <limits>
-#include <map>
+#include <array>
+#include <chrono>
 
 #ifndef SUDOKUSOLVER_H_
 #define SUDOKUSOLVER_H_
@@ -15,12 +19,28 @@ enum class GuessMode : char {
 
 std::ostream& operator << (std::ostream& os, GuessMode res);
 
+/** How the deterministic search chooses what to guess in */
+enum class Branching : char {
+	// the field with the fewest candidates
+	FewestCandidates,
+	// the same, ties broken by the most unsolved fields in its houses
+	MostConstrained,
+	// the field with the fewest candidates or the number with the fewest
+	// positions in a house, whichever has fewer alternatives
+	FewestPositions
+};
+
+std::ostream& operator << (std::ostream& os, Branching branching);
+
 class SudokuSolver {
 
 public:
 
 	enum class Result : char {
-		solved, impossible, ambiguos
+		solved, impossible, ambiguos,
+		// maxNodes, maxMicroseconds or the cancellation token stopped the
+		// search, see resume()
+		timeout
 	};
 
 	DATA_CONTAINER(Settings,
@@ -30,11 +50,29 @@ public:
 			((allowBlockBlock, bool, true, bool))
 			((allowNakedTuples, bool, true, bool))
 			((allowHiddenTuples, bool, true, bool))
-			((nextIterOnChange, bool, false, bool))
+			((allowFish, bool, true, bool))
+			((allowSimpleColoring, bool, true, bool))
+			((allowXYWing, bool, true, bool))
+			((allowXYChain, bool, true, bool))
+			((nextIterOnChange, bool, true, bool))
 			((guessMode, GuessMode, GuessMode::Deterministic, GuessMode))
 			((maxTupleSize, size_t, 3, size_t))
+			((maxFishSize, size_t, 3, size_t))
+			((maxXYChainLength, size_t, 6, size_t))
+			((maxColoringSteps, size_t, std::numeric_limits<size_t>::max(), size_t))
+			((maxXYWingSteps, size_t, std::numeric_limits<size_t>::max(), size_t))
+			((maxXYChainSteps, size_t, std::numeric_limits<size_t>::max(), size_t))
 			((maxNbGuesses, size_t, std::numeric_limits<size_t>::max(), size_t))
-			((maxResults, size_t, std::numeric_limits<size_t>::max(), size_t)),
+			((maxResults, size_t, std::numeric_limits<size_t>::max(), size_t))
+			((maxSearchMemory, size_t, std::numeric_limits<size_t>::max(), size_t))
+			((maxNodes, size_t, std::numeric_limits<size_t>::max(), size_t))
+			((maxMicroseconds, size_t, std::numeric_limits<size_t>::max(), size_t))
+			((randomSeed, uint64_t, 0, uint64_t))
+			((restartBacktracks, size_t, 0, size_t))
+			((branching, Branching, Branching::FewestCandidates, Branching))
+			((leastConstrainingValue, bool, false, bool))
+			((allowProbing, bool, false, bool))
+			((maxProbes, size_t, 64, size_t)),
 			(static Settings easy;)
 			(static Settings medium;)
 			(static Settings hard;)
@@ -42,14 +80,28 @@ public:
 
 	typedef std::deque<Sudoku> ResultList;
 
-	typedef std::vector<size_t> CandidateList;
-	typedef std::deque<size_t> FieldList;
-	typedef std::map<CandidateList,FieldList> TupleLookup;
+	/**
+	 * An open branch of the search: the board before a guess, the field
+	 * that was guessed and those of its candidates that are still to be
+	 * tried. The search keeps a stack of these instead of recursing.
+	 * If number is not 0, the guess was where to put number in the house
+	 * fieldIndex instead, and untried holds positions within the house
+	 * (see Sudoku::houseField, Branching::FewestPositions).
+	 */
+	struct SearchFrame {
+		Sudoku sudoku;
+		size_t fieldIndex;
+		Sudoku::CandidateMask untried;
+		// the step counters of the board, see max*Steps
+		size_t coloringSteps;
+		size_t xyWingSteps;
+		size_t xyChainSteps;
+		size_t number = 0;
+	};
 
 	SudokuSolver(
 			Settings const& settings,
-			Sudoku const& sudoku,
-			size_t depth=0
+			Sudoku const& sudoku
 	);
 
 	SudokuSolver(
@@ -58,84 +110,349 @@ public:
 
 	Result solve();
 
-	ResultList getSolved() {return m_results;}
+	/**
+	 * Replaces the sudoku and forgets all results, stats and derived data
+	 * of the previous one. The storage of the solver and of its child
+	 * solvers is kept, so solving many puzzles of the same geometry with
+	 * one solver avoids almost all setup cost.
+	 */
+	void reset(Sudoku const& sudoku);
+
+	/** Shorthand for reset(sudoku) followed by solve() */
+	Result solve(Sudoku const& sudoku);
+
+	/**
+	 * Searches the untried candidates of a frame, e.g. one split off the
+	 * frontier of another solver. The results and stats only cover this
+	 * part of the search.
+	 */
+	Result solve(SearchFrame const& frame);
+
+	/**
+	 * The open frames of the search, outermost first. When solve()
+	 * returns early because maxResults was reached, the frontier holds
+	 * the part of the search that was not done yet.
+	 */
+	size_t frontierSize() const {return m_nbFrames;}
+
+	SearchFrame const& frontierFrame(size_t i) const {return m_frames[i];}
+
+	/**
+	 * Removes the outermost open frame from the frontier, so that it can
+	 * be searched elsewhere with solve(frame). This splits the remaining
+	 * search into two disjoint parts. Returns false if the frontier is
+	 * empty.
+	 */
+	bool splitFrontier(SearchFrame & frame);
+
+	/**
+	 * Continues the search where the last solve stopped, with fresh
+	 * maxNodes and maxMicroseconds budgets. After Result::timeout, this
+	 * completes the interrupted search. After Result::solved with an open
+	 * frontier, it searches on until one more solution is found.
+	 * Otherwise it returns the last result again.
+	 */
+	Result resume();
+
+	/**
+	 * Makes the search return Result::timeout once the token is
+	 * cancelled. The token has to outlive the solves, nullptr removes it.
+	 */
+	void setCancellationToken(CancellationToken const* token) {m_cancellation=token;}
+
+	ResultList const& getSolved() const {return m_results;}
 
 	Sudoku const& getWorkingVersion() const {return m_sudoku;}
 
 	Sudoku & getWorkingVersion() {return m_sudoku;}
 
+	/** What the techniques and the search did so far */
+	SolverStats const& getStats() const {return m_stats;}
+
 private:
 
-	struct InteractionBlock {
-		Sudoku::FieldGroup fields;
-		// vector index: candidate/number
-		// set contains row/column indices where the candidate is possible
-		std::set<size_t> missingNumbers;
-		std::vector<size_t> referenceField;
-		std::vector<std::set<size_t>> possibleCols;
-		std::vector<std::set<size_t>> possibleRows;
+	// for one number: the rows and columns of each block in which
+	// the number is still a candidate, relative to the block
+	// index: BlockID
+	struct BlockLines {
+		std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> rows;
+		std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> columns;
 	};
 
-	//index: BlockID
-	typedef std::vector<InteractionBlock> InteractionStorage;
+	// the fields of one house with their candidates
+	// fixed size, so that tuple search does not need the heap
+	struct HouseCandidates {
+		size_t nbFields;
+		size_t nbUnsolved;
+		std::array<size_t, Sudoku::maxSideLength> fields;
+		std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> candidates;
+		// index: number-1, bit k is set if the number is possible in fields[k]
+		std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> positions;
+		// numbers that are not yet solved in the house
+		Sudoku::CandidateMask missingNumbers;
+	};
+
+	// a solving technique as scheduled by solveIteration
+	struct Strategy {
+		Technique technique;
+		// rough cost of one application relative to the other strategies
+		size_t cost;
+		void (SudokuSolver::*apply)();
+		// the Sudoku::version at which the strategy last found nothing
+		size_t idleVersion;
+	};
 
 	Settings m_settings;
 	Sudoku m_sudoku;
-	size_t m_depth;
 	bool m_changed = false;
 	ResultList m_results;
-
+	// the allowed strategies, cheapest first
+	std::vector<Strategy> m_strategies;
+	SolverStats m_stats;
+
+	// for coloring and chains
+	LinkGraph m_links;
+	// how often each technique was applied successfully, see max*Steps
+	size_t m_coloringSteps = 0;
+	size_t m_xyWingSteps = 0;
+	size_t m_xyChainSteps = 0;
+	// the search stack, only the first m_nbFrames are open. The others
+	// keep their boards, so that each depth allocates only once.
+	std::vector<SearchFrame> m_frames;
+	size_t m_nbFrames = 0;
+	// seeded from randomSeed, see RandomEngine::makeSeed
+	RandomEngine m_randomEngine;
+	// whether the board in m_sudoku is the given one, which is not
+	// guessed in if guessing is disallowed (Result::ambiguos)
+	bool m_atRoot = false;
+	// the propagated given board that random restarts return to, see
+	// restartDue. Only set by a search that started at the given board.
+	SearchFrame m_restartPoint;
+	bool m_canRestart = false;
+	size_t m_nbRestarts = 0;
+	// the backtracks at the last restart
+	size_t m_restartBacktracks = 0;
+	Result m_result = Result::ambiguos;
+
+	// the budgets of the current solve, see startBudgets
+	size_t m_nodeLimit = std::numeric_limits<size_t>::max();
+	bool m_hasDeadline = false;
+	std::chrono::steady_clock::time_point m_deadline;
+	CancellationToken const* m_cancellation = nullptr;
+	// scratch space for coloring and chains (index: field)
+	std::vector<size_t> m_colors;
+	std::vector<size_t> m_queue;
+	std::vector<size_t> m_seen;
+	std::vector<char> m_visited;
+	// the board that probes are tried on, and the trail undoing them
+	Sudoku m_probe;
+	Sudoku::Trail m_trail;
+
+	// fills m_strategies according to the settings
+	void registerStrategies();
+
+	// reserves the scratch space of the allowed techniques
+	void reserveScratch();
+
+	void addStrategy(
+			Technique technique,
+			size_t cost,
+			void (SudokuSolver::*apply)());
+
+	// runs the strategies cheapest first, skipping those that found
+	// nothing since the last change of the candidates. If
+	// nextIterOnChange is set, it returns as soon as one of them changed
+	// something, so the next iteration starts again with the cheapest.
 	Result solveIteration();
 
+	// runs the search while measuring its allocations and keeps the
+	// result for resume
+	Result runMeasured(bool continued);
+
+	// searches until the frontier is exhausted, maxResults is reached or
+	// the budgets run out, starting with the board in m_sudoku
+	Result runSearch();
+
+	// iterates until nothing changes
+	Result propagate();
+
+	// sets the node limit and the deadline from the settings
+	void startBudgets();
+
+	// whether the deadline has passed or the search was cancelled
+	bool interrupted() const;
+
+	// whether the settings allow another guess on the current board
+	bool canBranch();
+
+	// guesses as chosen by the branching setting (or in a random field),
+	// pushing a frame if further alternatives remain. Returns false if an
+	// unsolved field has no candidates left.
+	bool branch();
+
+	// the unsolved field with the fewest candidates, see Branching.
+	// Returns nbFields if one has no candidates left.
+	size_t selectField() const;
+
+	// the house and number with the fewest positions, if fewer than
+	// maxPositions (see Branching::FewestPositions)
+	bool selectPositions(size_t maxPositions, size_t & house, size_t & number) const;
+
+	// takes the next alternative of a guess on board (see SearchFrame)
+	// out of untried. Returns the field to guess in, guessedNumber is set
+	// to the number to enter.
+	size_t takeGuess(Sudoku const& board, size_t fieldIndex, size_t number,
+			Sudoku::CandidateMask & untried, size_t & guessedNumber);
+
+	// replaces the board by the next untried guess of the innermost
+	// frame, returns false if the frontier is empty
+	bool nextGuess();
+
+	// the next candidate of a field to try out of a mask, which is
+	// removed from it
+	size_t takeCandidate(Sudoku const& board, size_t fieldIndex,
+			Sudoku::CandidateMask & untried);
+
+	// whether the random search has backtracked restartBacktracks times
+	// the next term of the Luby sequence since the last restart
+	bool restartDue() const;
+
+	// drops the search stack and continues at the restart point
+	void restart();
+
+	// forgets what the strategies derived from the versions of the board,
+	// after the board was replaced by an older one
+	void invalidateDerived();
+
 	// check for naked singles
 	void workFields();
 	void workField(size_t fieldIndex);
 
-	// check for hidden singles
-	void workRows();
-	void workColumns();
-	void workBlocks();
-	void workGroup(Sudoku::FieldGroup const& group);
+	// check for hidden singles in all rows, columns and blocks
+	void workHouses();
 
 	void checkInteractions();
 
-	void findPossibleRowsAndColumns(InteractionStorage & blockInfo);
-	void findPossibleRowsAndColumns(InteractionBlock & block);
+	void findBlockLines(size_t number, BlockLines & lines) const;
 
-	// check for block-row/column/block interactions
-	// should only be called with a block as group
-	void checkBlockRowColInteractions(InteractionStorage const& blockInfo);
-	void applyBlockRowColInteractions(
-			Sudoku::FieldGroup const& origGroup,
-			size_t refFieldIndex,
-			size_t number,
-			bool row);
+	// check for block-row/column interactions: if a candidate is possible
+	// in only one row/column of a block, it is impossible in the rest of
+	// that row/column (pointing)
+	void checkBlockRowColInteractions(size_t number, BlockLines const& lines);
+
+	// check for row/column-block interactions: if a candidate is possible
+	// in only one block of a row/column, it is impossible in the rest of
+	// that block (claiming)
+	void checkRowColBlockInteractions(size_t number);
 
 	// for block-block interaction, a candidate must be possible in only the
 	// same two rows/columns in the two blocks of the same block row/column
 	// then, the candidate is impossible for all fields of the same two
 	// rows/columns in all other blocks of that block row/column
-	void checkBlockBlockInteractions(InteractionStorage const& blockInfo);
-	void applyBlockBlockInteractions(
-			InteractionBlock const& block1,
-			InteractionBlock const& block2,
-			std::set<size_t> const& rowOrColumnIndices,
-			size_t number,
-			bool row);
+	void checkBlockBlockInteractions(size_t number, BlockLines const& lines);
 
-	void checkTuples();
-	void checkTuples(size_t nbTupleElements);
-	void checkTuples(
-			TupleLookup::const_iterator tuple,
-			FieldList const& tupleIndices,
-			Sudoku::FieldGroup const& group
-	);
+	// mask of the positions within a row that belong to a block column
+	Sudoku::CandidateMask blockColumnPositions(size_t blockColumn) const;
 
-	void educatedGuess();
+	// mask of the positions within a column that belong to a block row
+	Sudoku::CandidateMask blockRowPositions(size_t blockRow) const;
 
-	void randomGuess();
+	// removes a number from the fields at the given positions of a house
+	void eliminate(size_t house, size_t number, Sudoku::CandidateMask positions);
+
+	// check for naked and hidden tuples of up to maxTupleSize elements
+	void checkTuples();
+	void getHouseCandidates(size_t house, HouseCandidates& info) const;
+
+	// naked tuple: N fields of a house that share only N candidates.
+	// These candidates are impossible for all other fields of the house.
+	// Enumerates field subsets, returns true if candidates were removed.
+	bool checkNakedTuples(
+			HouseCandidates const& info,
+			size_t tupleSize,
+			size_t firstField,
+			size_t nbChosen,
+			Sudoku::CandidateMask chosenFields,
+			Sudoku::CandidateMask numbers);
+
+	// hidden tuple: N numbers that are only possible in the same N fields
+	// of a house. All other candidates of these fields are impossible.
+	// Enumerates number subsets, returns true if candidates were removed.
+	bool checkHiddenTuples(
+			HouseCandidates const& info,
+			size_t tupleSize,
+			size_t firstNumber,
+			size_t nbChosen,
+			Sudoku::CandidateMask chosenNumbers,
+			Sudoku::CandidateMask fields);
+
+	// basic fish (X-Wing, Swordfish, Jellyfish, ...): if a number is
+	// possible in N rows only within the same N columns, it is impossible
+	// in these columns for all other rows (and vice versa)
+	void checkFish();
+
+	// positions of a number in every row (or column), returns the
+	// number of rows/columns in which it is still possible
+	size_t findFishBases(
+			size_t number,
+			bool rows,
+			std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> & baseSets) const;
 
-	void moveResults(SudokuSolver & other);
+	// enumerates subsets of base rows/columns, returns true if
+	// candidates were removed
+	bool checkFish(
+			size_t number,
+			bool rows,
+			std::array<Sudoku::CandidateMask, Sudoku::maxSideLength> const& baseSets,
+			size_t fishSize,
+			size_t firstBase,
+			size_t nbChosen,
+			Sudoku::CandidateMask chosenBases,
+			Sudoku::CandidateMask coverSets);
+
+	// simple coloring: the fields of a number connected by strong links are
+	// colored alternately, so exactly one of the two colors is true.
+	// A color is false if two of its fields see each other. Fields seeing
+	// both colors cannot contain the number.
+	void checkSimpleColoring();
+	bool checkSimpleColoring(size_t number);
+
+	// XY-Wing: a bivalue pivot {a,b} seeing the bivalue pincers {a,c} and
+	// {b,c}. One of the pincers must be c, so fields seeing both pincers
+	// cannot contain c.
+	// XYZ-Wing: a pivot {a,b,c} seeing the bivalue pincers {a,c} and {b,c}.
+	// Fields seeing the pivot and both pincers cannot contain c.
+	void checkXYWings();
+	bool checkXYWing(size_t pivot);
+	bool checkXYZWing(size_t pivot);
+
+	// XY-Chain: a chain of bivalue fields, each sharing a house and a number
+	// with the next, where the first field is {z,a} and the last one {b,z}.
+	// Either the first or the last field is z, so fields seeing both cannot
+	// contain z. Chains are limited to maxXYChainLength fields.
+	void checkXYChains();
+	bool checkXYChain(
+			size_t start,
+			size_t number,
+			size_t fieldIndex,
+			size_t forcedNumber,
+			size_t length);
+
+	// failed literals: enters the candidates of the fields with the fewest
+	// candidates into a copy of the board and removes those for which
+	// naked and hidden singles alone lead to a contradiction. Each probe
+	// is undone through the trail of the copy. At most maxProbes probes
+	// per call.
+	void checkProbes();
+
+	// whether the probe board survives the singles following a placement
+	bool probeSingles();
+
+	// removes a number from all fields seeing all of the given fields
+	bool eliminateSeenByAll(
+			size_t number,
+			size_t const* fields,
+			size_t nbFields);
 
 };
 
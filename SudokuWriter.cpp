@@ -0,0 +1,111 @@
+#include "SudokuWriter.h"
+#include "PackedSudoku.h"
+#include <stdexcept>
+
+void SudokuWriter::appendGrid(Sudoku const& sudoku)
+{
+	GridPoint p;
+	for(p.y=0; p.y<sudoku.sideLength(); ++p.y) {
+		for(p.x=0; p.x<sudoku.sideLength(); ++p.x)
+			appendCell(sudoku.getSolution(p), 4);
+		m_buffer += '\n';
+	}
+}
+
+void SudokuWriter::appendFramed(Sudoku const& sudoku)
+{
+	GridPoint p;
+	for(p.y=0; p.y<sudoku.sideLength(); ++p.y) {
+		if(p.y % sudoku.blockHeight() == 0)
+			appendFrameLine(sudoku.nbBlockColumns(), sudoku.blockWidth()*4);
+		for(p.x=0; p.x<sudoku.sideLength(); ++p.x) {
+			if(p.x % sudoku.blockWidth() == 0)
+				m_buffer += '|';
+			appendCell(sudoku.getSolution(p), 4);
+		}
+		m_buffer += "|\n";
+	}
+	appendFrameLine(sudoku.nbBlockColumns(), sudoku.blockWidth()*4);
+}
+
+void SudokuWriter::appendCandidates(Sudoku const& sudoku)
+{
+	size_t const fieldWidth(3);
+	size_t blockWidth(sudoku.blockWidth()), blockHeight(sudoku.blockHeight());
+	GridPoint p;
+	for(p.y=0; p.y<sudoku.sideLength(); ++p.y) {
+		appendFrameLine(sudoku.sideLength(), blockWidth*fieldWidth);
+		// each field shows its candidates as a small blockWidth x blockHeight grid
+		for(size_t y(0); y<blockHeight; y++) {
+			size_t number(y*blockHeight);
+			for(p.x=0; p.x<sudoku.sideLength(); ++p.x) {
+				m_buffer += '|';
+				for(size_t x(0); x<blockWidth; x++) {
+					if(!sudoku.isSolved(p) && sudoku.isCandidate(p, number+1))
+						appendCell(number+1, fieldWidth);
+					else
+						m_buffer.append(fieldWidth, ' ');
+					number = y*blockHeight + (number+1) % blockHeight;
+				}
+			}
+			m_buffer += "|\n";
+		}
+	}
+	appendFrameLine(sudoku.sideLength(), blockWidth*fieldWidth);
+}
+
+void SudokuWriter::appendLine(Sudoku const& sudoku)
+{
+	if(sudoku.sideLength()>35)
+		throw std::runtime_error("SudokuWriter: single-line sudokus are limited to a side length of 35");
+	static char const digits[] = ".123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	GridPoint p;
+	for(p.y=0; p.y<sudoku.sideLength(); ++p.y)
+		for(p.x=0; p.x<sudoku.sideLength(); ++p.x)
+			m_buffer += digits[sudoku.getSolution(p)];
+	m_buffer += '\n';
+}
+
+void SudokuWriter::appendPackedHeader(size_t sideLength, size_t blockWidth)
+{
+	size_t offset(m_buffer.size());
+	m_buffer.resize(offset+PackedFormat::headerSize);
+	PackedFormat::writeHeader(&m_buffer[offset], sideLength, blockWidth);
+}
+
+void SudokuWriter::appendPacked(Sudoku const& sudoku)
+{
+	size_t offset(m_buffer.size());
+	m_buffer.resize(offset+PackedFormat::recordSize(sudoku.sideLength()));
+	PackedFormat::packRecord(sudoku, &m_buffer[offset]);
+}
+
+void SudokuWriter::flush(std::ostream & os)
+{
+	os.write(m_buffer.data(), m_buffer.size());
+	os.flush();
+	m_buffer.clear();
+}
+
+void SudokuWriter::appendCell(size_t number, size_t width)
+{
+	// numbers have at most two digits (see Sudoku::maxSideLength)
+	size_t nbDigits(number==0 || number<10 ? 1 : 2);
+	m_buffer.append(width-nbDigits, ' ');
+	if(number==0)
+		m_buffer += '?';
+	else {
+		if(number>=10)
+			m_buffer += static_cast<char>('0'+number/10);
+		m_buffer += static_cast<char>('0'+number%10);
+	}
+}
+
+void SudokuWriter::appendFrameLine(size_t nbCells, size_t cellWidth)
+{
+	for(size_t i(0); i<nbCells; i++) {
+		m_buffer += '+';
+		m_buffer.append(cellWidth, '-');
+	}
+	m_buffer += "+\n";
+}
@@ -0,0 +1,62 @@
+#ifndef SUDOKUWRITER_H_
+#define SUDOKUWRITER_H_
+
+#include "Sudoku.h"
+#include <ostream>
+#include <string>
+
+/**
+ * Formats sudokus into one contiguous buffer, which is then written with
+ * a single call. Unlike formatting through a stream field by field, with
+ * std::setw and a flush after every row, a whole batch of boards costs
+ * one write. The buffer keeps its capacity when flushed or cleared, so a
+ * writer used for many boards stops allocating.
+ *
+ * Formats:
+ * - grid: the format of operator<< and of the sudoku files
+ * - framed: the grid with block frames, as printed by Sudoku::print
+ * - candidates: the candidates of all fields, see Sudoku::printCandidates
+ * - line: the single-line format read by SudokuParser
+ * - packed: records of the binary format, see PackedFormat
+ */
+class SudokuWriter {
+
+public:
+
+	void appendGrid(Sudoku const& sudoku);
+
+	void appendFramed(Sudoku const& sudoku);
+
+	void appendCandidates(Sudoku const& sudoku);
+
+	/** Throws for side lengths above 35, which have no single-line digit */
+	void appendLine(Sudoku const& sudoku);
+
+	/** The header of a packed file, to be followed by appendPacked */
+	void appendPackedHeader(size_t sideLength, size_t blockWidth);
+
+	void appendPacked(Sudoku const& sudoku);
+
+	/** Appends plain text, e.g. a heading between boards */
+	void append(std::string const& text) {m_buffer += text;}
+
+	std::string const& buffer() const {return m_buffer;}
+
+	size_t size() const {return m_buffer.size();}
+
+	void clear() {m_buffer.clear();}
+
+	/** Writes the buffer with one call and clears it */
+	void flush(std::ostream & os);
+
+private:
+
+	// a number or "?" right-aligned in a cell of the given width
+	void appendCell(size_t number, size_t width);
+
+	void appendFrameLine(size_t nbCells, size_t cellWidth);
+
+	std::string m_buffer;
+};
+
+#endif /* SUDOKUWRITER_H_ */
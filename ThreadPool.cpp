@@ -0,0 +1,83 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t nbThreads, size_t maxQueueDepth) :
+		m_maxQueueDepth(maxQueueDepth),
+		m_metrics{0, 0, 0, 0, 0}
+{
+	if(nbThreads==0)
+		nbThreads=std::max<size_t>(1, std::thread::hardware_concurrency());
+	m_threads.reserve(nbThreads);
+	for(size_t i(0); i<nbThreads; ++i)
+		m_threads.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping=true;
+	}
+	m_notEmpty.notify_all();
+	for(auto & thread : m_threads)
+		thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_notFull.wait(lock, [this] {return !full();});
+	push(std::move(task));
+}
+
+bool ThreadPool::trySubmit(std::function<void()> task)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if(full()) {
+		++m_metrics.rejected;
+		return false;
+	}
+	push(std::move(task));
+	return true;
+}
+
+ThreadPool::Metrics ThreadPool::metrics() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_metrics;
+}
+
+bool ThreadPool::full() const
+{
+	return m_maxQueueDepth>0 && m_queue.size()>=m_maxQueueDepth;
+}
+
+void ThreadPool::push(std::function<void()> && task)
+{
+	m_queue.push_back(std::move(task));
+	m_metrics.queueDepth=m_queue.size();
+	m_metrics.peakQueueDepth=std::max(m_metrics.peakQueueDepth, m_queue.size());
+	m_notEmpty.notify_one();
+}
+
+void ThreadPool::work()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(true) {
+		m_notEmpty.wait(lock, [this] {return m_stopping || !m_queue.empty();});
+		if(m_queue.empty())
+			return; // stopping and nothing left to do
+		std::function<void()> task(std::move(m_queue.front()));
+		m_queue.pop_front();
+		m_metrics.queueDepth=m_queue.size();
+		++m_metrics.running;
+		m_notFull.notify_one();
+
+		lock.unlock();
+		task();
+		lock.lock();
+
+		--m_metrics.running;
+		++m_metrics.completed;
+	}
+}
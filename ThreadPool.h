@@ -0,0 +1,79 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed number of worker threads fed by a bounded queue. submit()
+ * blocks while the queue is full, trySubmit() refuses the task instead,
+ * so that event loop threads never block on a busy pool.
+ */
+class ThreadPool {
+
+public:
+
+	struct Metrics {
+		/*! tasks waiting for a worker */
+		size_t queueDepth;
+		/*! the largest queueDepth so far */
+		size_t peakQueueDepth;
+		/*! tasks currently executed */
+		size_t running;
+		size_t completed;
+		/*! tasks refused by trySubmit because the queue was full */
+		size_t rejected;
+	};
+
+	/**
+	 * nbThreads 0 uses one thread per hardware thread, maxQueueDepth 0
+	 * allows an unbounded queue
+	 */
+	ThreadPool(size_t nbThreads, size_t maxQueueDepth);
+
+	/** Finishes all queued tasks, then joins the workers */
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+	/**
+	 * Queues a task, waiting for space if the queue is full. Tasks must
+	 * not throw, an escaping exception terminates the program.
+	 */
+	void submit(std::function<void()> task);
+
+	/** Queues a task if there is space, returns false otherwise */
+	bool trySubmit(std::function<void()> task);
+
+	Metrics metrics() const;
+
+	size_t nbThreads() const {return m_threads.size();}
+
+	size_t maxQueueDepth() const {return m_maxQueueDepth;}
+
+private:
+
+	void work();
+
+	bool full() const;
+
+	// with m_mutex locked
+	void push(std::function<void()> && task);
+
+	size_t m_maxQueueDepth;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_notEmpty;
+	std::condition_variable m_notFull;
+	std::deque<std::function<void()>> m_queue;
+	Metrics m_metrics;
+	bool m_stopping = false;
+	std::vector<std::thread> m_threads;
+};
+
+#endif /* THREADPOOL_H_ */
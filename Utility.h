@@ -2,6 +2,8 @@
 #define UTILITY_H_
 
 #include <type_traits>
+#include <cstdint>
+#include <cstddef>
 
 // Helper to determine whether there's a const_iterator for T.
 template<typename T>
@@ -26,5 +28,16 @@ contains(Container const& c, typename Container::value_type const& t)
 	return false;
 }
 
+// number of set bits in a mask
+inline size_t popCount(uint64_t mask)
+{
+	return static_cast<size_t>(__builtin_popcountll(mask));
+}
+
+// position of the lowest set bit in a mask (mask must not be zero)
+inline size_t lowestBit(uint64_t mask)
+{
+	return static_cast<size_t>(__builtin_ctzll(mask));
+}
 
 #endif /* UTILITY_H_ */
@@ -0,0 +1,30 @@
+#ifndef BENCH_BENCHOPTIONS_H_
+#define BENCH_BENCHOPTIONS_H_
+
+#include <stdexcept>
+#include <string>
+
+/**
+ * The numeric value of a command line option of the benchmark tools.
+ * Only digits are accepted, since std::stoul would silently wrap a
+ * negative value around. Throws if the value is missing, not a number,
+ * too large for size_t or below min.
+ */
+inline size_t toSize(std::string const& option, char const* value, size_t min = 0) {
+	if(!value)
+		throw std::runtime_error(option+" needs a value");
+	std::string number(value);
+	if(number.empty() || number.find_first_not_of("0123456789")!=std::string::npos)
+		throw std::runtime_error("could not interpret "+number+" as value of "+option);
+	size_t result(0);
+	try {
+		result=std::stoul(number);
+	} catch(std::out_of_range &) {
+		throw std::runtime_error("the value "+number+" of "+option+" is too large");
+	}
+	if(result<min)
+		throw std::runtime_error(option+" must be at least "+std::to_string(min));
+	return result;
+}
+
+#endif /* BENCH_BENCHOPTIONS_H_ */
@@ -0,0 +1,303 @@
+/******************************************************************************
+ * Benchmark of the SudokuSolver and the SudokuGenerator.
+ *
+ * Every corpus file is solved with every predefined solver setting and the
+ * generator creates puzzles for the small sizes and all difficulties. For
+ * each combination the median, the 99th percentile and the throughput are
+ * written as JSON, so results of different commits can be compared.
+ * stdout carries nothing but the JSON unless --output is given.
+ *
+ * With --check-allocations, the corpus is only solved without guessing and
+ * the program fails if the propagation loop of any solve allocated memory
+ * (requires SUDOKU_COUNT_ALLOCATIONS, see AllocationCounter).
+ *
+ * usage: bench [--corpus <dir>] [--output <file>] [--warmup <n>]
+ *              [--repetitions <n>] [--generate <n>] [--no-generator]
+ *              [--check-allocations]
+ *****************************************************************************/
+
+#include "../SudokuGenerator.h"
+#include "../SudokuSolver.h"
+#include "../AllocationCounter.h"
+#include "BenchOptions.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+	std::string corpus = "bench/corpus";
+	std::string output; // stdout if empty
+	size_t warmup = 1;
+	size_t repetitions = 5;
+	size_t nbGenerated = 5;
+	bool generator = true;
+	bool checkAllocations = false;
+};
+
+struct Summary {
+	size_t nbSamples;
+	uint64_t median;
+	uint64_t p99;
+	uint64_t mean;
+	double throughput; // per second
+	double allocations; // per sample
+};
+
+// the checked-in puzzles, one file per geometry (and difficulty). Each
+// 9x9 puzzle is rated by the easiest preset that solves it; 9x9_unrated
+// holds puzzles that no preset solves within its guess limit
+char const* const corpusFiles[] = {
+	"4x4",
+	"6x6",
+	"9x9_easy",
+	"9x9_medium",
+	"9x9_hard",
+	"9x9_extreme",
+	"9x9_unrated",
+	"12x12",
+	"16x16"
+};
+
+char const* const difficulties[] = {"easy", "medium", "hard", "extreme"};
+
+SudokuSolver::Settings const& solverSettings(size_t difficulty) {
+	SudokuSolver::Settings const* settings[] = {
+		&SudokuSolver::Settings::easy,
+		&SudokuSolver::Settings::medium,
+		&SudokuSolver::Settings::hard,
+		&SudokuSolver::Settings::extreme
+	};
+	return *settings[difficulty];
+}
+
+SudokuGenerator::Settings const& generatorSettings(size_t difficulty) {
+	SudokuGenerator::Settings const* settings[] = {
+		&SudokuGenerator::Settings::easy,
+		&SudokuGenerator::Settings::medium,
+		&SudokuGenerator::Settings::hard,
+		&SudokuGenerator::Settings::extreme
+	};
+	return *settings[difficulty];
+}
+
+std::vector<Sudoku> readCorpus(std::string const& fileName) {
+	std::ifstream file(fileName);
+	if(!file)
+		throw std::runtime_error("could not open corpus file "+fileName);
+	std::vector<Sudoku> puzzles;
+	while(file >> std::ws && !file.eof()) {
+		Sudoku sudoku;
+		file >> sudoku;
+		puzzles.push_back(sudoku);
+	}
+	return puzzles;
+}
+
+uint64_t elapsed(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now()-start).count();
+}
+
+Summary summarize(std::vector<uint64_t> & samples, size_t allocations) {
+	Summary summary{samples.size(), 0, 0, 0, 0.0, 0.0};
+	if(samples.empty()) return summary;
+	std::sort(samples.begin(), samples.end());
+	uint64_t total(0);
+	for(auto s : samples) total += s;
+	// nearest rank percentiles
+	summary.median = samples[(samples.size()-1)/2];
+	summary.p99 = samples[(samples.size()*99+99)/100-1];
+	summary.mean = total/samples.size();
+	summary.throughput = total>0 ? samples.size()*1e9/total : 0.0;
+	summary.allocations = static_cast<double>(allocations)/samples.size();
+	return summary;
+}
+
+void printSummary(std::ostream& os, Summary const& summary) {
+	os << "\"samples\": " << summary.nbSamples
+			<< ", \"median_ns\": " << summary.median
+			<< ", \"p99_ns\": " << summary.p99
+			<< ", \"mean_ns\": " << summary.mean
+			<< ", \"throughput_per_s\": " << summary.throughput
+			<< ", \"allocations\": " << summary.allocations;
+}
+
+// solves all puzzles once, returns the number of solved ones
+size_t solveAll(
+		std::vector<Sudoku> const& puzzles,
+		SudokuSolver::Settings const& settings,
+		std::vector<uint64_t>* samples,
+		size_t* allocations=nullptr
+) {
+	size_t nbSolved(0);
+	if(puzzles.empty()) return 0;
+	// one solver for all puzzles, as in a batch run
+	SudokuSolver solver(settings, puzzles.front());
+	for(auto const& puzzle : puzzles) {
+		auto start(std::chrono::steady_clock::now());
+		if(solver.solve(puzzle)==SudokuSolver::Result::solved)
+			++nbSolved;
+		if(samples)
+			samples->push_back(elapsed(start));
+		if(allocations)
+			*allocations += solver.getStats().allocations;
+	}
+	return nbSolved;
+}
+
+// whether an allocation made here is actually counted
+bool countsAllocations() {
+	size_t before(AllocationCounter::count());
+	void* volatile ptr(::operator new(1));
+	::operator delete(ptr);
+	return AllocationCounter::count()>before;
+}
+
+// returns false if the propagation loop allocated for any puzzle
+bool checkAllocations(Options const& options) {
+	if(!AllocationCounter::enabled() || !countsAllocations())
+		throw std::runtime_error("--check-allocations needs a build with SUDOKU_COUNT_ALLOCATIONS");
+	bool success(true);
+	for(auto corpus : corpusFiles) {
+		std::vector<Sudoku> puzzles(readCorpus(options.corpus+"/"+corpus+".txt"));
+		for(size_t d(0); d<4; ++d) {
+			SudokuSolver::Settings settings(solverSettings(d));
+			settings.maxNbGuesses(0);
+			for(size_t i(0); i<puzzles.size(); ++i) {
+				SudokuSolver solver(settings, puzzles[i]);
+				solver.solve();
+				size_t allocations(solver.getStats().iterationAllocations);
+				if(allocations==0) continue;
+				std::cerr << corpus << " puzzle " << i << " preset " << difficulties[d]
+						<< ": " << allocations << " allocation(s) in the propagation loop" << std::endl;
+				success=false;
+			}
+		}
+	}
+	return success;
+}
+
+void benchSolver(Options const& options, std::ostream& os) {
+	os << "  \"solver\": [";
+	bool first(true);
+	for(auto corpus : corpusFiles) {
+		std::vector<Sudoku> puzzles(readCorpus(options.corpus+"/"+corpus+".txt"));
+		for(size_t d(0); d<4; ++d) {
+			SudokuSolver::Settings const& settings(solverSettings(d));
+			for(size_t i(0); i<options.warmup; ++i)
+				solveAll(puzzles, settings, nullptr);
+			std::vector<uint64_t> samples;
+			size_t nbSolved(0);
+			size_t allocations(0);
+			for(size_t i(0); i<options.repetitions; ++i)
+				nbSolved = solveAll(puzzles, settings, &samples, &allocations);
+
+			os << (first ? "\n" : ",\n") << "    {\"corpus\": \"" << corpus
+					<< "\", \"preset\": \"" << difficulties[d]
+					<< "\", \"puzzles\": " << puzzles.size()
+					<< ", \"solved\": " << nbSolved << ", ";
+			printSummary(os, summarize(samples, allocations));
+			os << "}";
+			first=false;
+		}
+	}
+	os << "\n  ]";
+}
+
+void benchGenerator(Options const& options, std::ostream& os) {
+	os << "  \"generator\": [";
+	bool first(true);
+	// the generator only works reliably for small sizes
+	for(size_t size : {4, 6, 9}) {
+		for(size_t d(0); d<4; ++d) {
+			// the progress output would end up in the JSON on stdout
+			SudokuGenerator::Settings settings(generatorSettings(d));
+			settings.printProgress(false);
+			std::vector<uint64_t> samples;
+			size_t nbGenerated(0);
+			size_t allocations(0);
+			for(size_t i(0); i<options.warmup+options.nbGenerated; ++i) {
+				size_t allocationsBefore(AllocationCounter::count());
+				auto start(std::chrono::steady_clock::now());
+				SudokuGenerator generator(settings, Sudoku(size));
+				bool success(generator.generate());
+				if(i<options.warmup) continue;
+				samples.push_back(elapsed(start));
+				allocations += AllocationCounter::count()-allocationsBefore;
+				if(success) ++nbGenerated;
+			}
+
+			os << (first ? "\n" : ",\n") << "    {\"size\": " << size
+					<< ", \"difficulty\": \"" << difficulties[d]
+					<< "\", \"generated\": " << nbGenerated << ", ";
+			printSummary(os, summarize(samples, allocations));
+			os << "}";
+			first=false;
+		}
+	}
+	os << "\n  ]";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	try {
+		Options options;
+		for(int i=1; i<argc; i++) {
+			std::string option(argv[i]);
+			char const* value(i+1<argc ? argv[i+1] : nullptr);
+			if(option=="--corpus") {
+				if(!value) throw std::runtime_error("--corpus needs a value");
+				options.corpus=value; ++i;
+			} else if(option=="--output") {
+				if(!value) throw std::runtime_error("--output needs a value");
+				options.output=value; ++i;
+			} else if(option=="--warmup") {
+				options.warmup=toSize(option, value); ++i;
+			} else if(option=="--repetitions") {
+				options.repetitions=toSize(option, value, 1); ++i;
+			} else if(option=="--generate") {
+				options.nbGenerated=toSize(option, value); ++i;
+			} else if(option=="--no-generator") {
+				options.generator=false;
+			} else if(option=="--check-allocations") {
+				options.checkAllocations=true;
+			} else
+				throw std::runtime_error("unknown option "+option);
+		}
+
+		if(options.checkAllocations) {
+			if(!checkAllocations(options))
+				return 1;
+			std::cout << "no allocations in the propagation loop" << std::endl;
+			return 0;
+		}
+
+		std::ofstream file;
+		if(!options.output.empty()) {
+			file.open(options.output);
+			if(!file)
+				throw std::runtime_error("could not open "+options.output);
+		}
+		std::ostream& os(options.output.empty() ? std::cout : file);
+
+		os << "{\n  \"warmup\": " << options.warmup
+				<< ",\n  \"repetitions\": " << options.repetitions << ",\n";
+		benchSolver(options, os);
+		if(options.generator) {
+			os << ",\n";
+			benchGenerator(options, os);
+		}
+		os << "\n}" << std::endl;
+
+	} catch(std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+}
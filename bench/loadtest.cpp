@@ -0,0 +1,186 @@
+/******************************************************************************
+ * Load test of the SudokuServer ("SudokuSolver serve <address>").
+ *
+ * Opens several connections, each of which sends solve requests for the
+ * corpus puzzles with up to --window requests in flight (pipelining). The
+ * latency of every request is measured from sending it to receiving its
+ * response. The median, the 99th percentile and the throughput are
+ * written as JSON.
+ *
+ * usage: loadtest [--address <address>] [--corpus <dir>] [--difficulty <d>]
+ *                 [--connections <n>] [--requests <n>] [--window <n>]
+ *                 [--output <file>]
+ *****************************************************************************/
+
+#include "../Sudoku.h"
+#include "../Socket.h"
+#include "BenchOptions.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+	std::string address = "tcp:7878";
+	std::string corpus = "bench/corpus";
+	std::string difficulty = "extreme";
+	size_t nbConnections = 4;
+	size_t nbRequests = 1000; // per connection
+	size_t window = 16;
+	std::string output; // stdout if empty
+};
+
+char const* const corpusFiles[] = {
+	"4x4", "6x6", "9x9_easy", "9x9_medium", "9x9_hard", "9x9_extreme", "12x12", "16x16"
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// the corpus puzzles as request lines
+std::vector<std::string> readRequests(Options const& options) {
+	std::vector<std::string> requests;
+	for(auto corpus : corpusFiles) {
+		std::string fileName(options.corpus+"/"+corpus+".txt");
+		std::ifstream file(fileName);
+		if(!file)
+			throw std::runtime_error("could not open corpus file "+fileName);
+		while(file >> std::ws && !file.eof()) {
+			Sudoku sudoku;
+			file >> sudoku;
+			std::ostringstream request;
+			request << "solve " << options.difficulty << ' ' << sudoku.sideLength();
+			for(size_t y(0); y<sudoku.sideLength(); ++y) {
+				for(size_t x(0); x<sudoku.sideLength(); ++x) {
+					size_t number(sudoku.getSolution(GridPoint(x, y)));
+					if(number>0)
+						request << ' ' << number;
+					else
+						request << " ?";
+				}
+			}
+			request << '\n';
+			requests.push_back(request.str());
+		}
+	}
+	return requests;
+}
+
+struct ConnectionResult {
+	std::vector<uint64_t> latencies; // ns
+	size_t nbErrors = 0;
+	std::string failure;
+};
+
+void runConnection(
+		Options const& options,
+		std::vector<std::string> const& requests,
+		size_t offset,
+		ConnectionResult & result
+) {
+	try {
+		int fd(connectTo(options.address));
+		LineReader reader(fd);
+		std::deque<Clock::time_point> inFlight;
+		std::string line;
+		size_t nbSent(0);
+		result.latencies.reserve(options.nbRequests);
+		while(result.latencies.size()<options.nbRequests) {
+			while(nbSent<options.nbRequests && inFlight.size()<options.window) {
+				inFlight.push_back(Clock::now());
+				if(!writeAll(fd, requests[(offset+nbSent)%requests.size()]))
+					throw std::runtime_error("connection closed while sending");
+				++nbSent;
+			}
+			if(!reader.readLine(line))
+				throw std::runtime_error("connection closed while receiving");
+			result.latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					Clock::now()-inFlight.front()).count());
+			inFlight.pop_front();
+			if(line.compare(0, 6, "error ")==0)
+				++result.nbErrors;
+		}
+		writeAll(fd, "quit\n");
+		closeSocket(fd);
+	} catch(std::exception &e) {
+		result.failure=e.what();
+	}
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	try {
+		Options options;
+		for(int i=1; i<argc; i++) {
+			std::string option(argv[i]);
+			char const* value(i+1<argc ? argv[i+1] : nullptr);
+			if(option=="--address" || option=="--corpus" || option=="--difficulty" || option=="--output") {
+				if(!value) throw std::runtime_error(option+" needs a value");
+				std::string & target(option=="--address" ? options.address :
+						option=="--corpus" ? options.corpus :
+						option=="--difficulty" ? options.difficulty : options.output);
+				target=value; ++i;
+			} else if(option=="--connections") {
+				options.nbConnections=toSize(option, value, 1); ++i;
+			} else if(option=="--requests") {
+				options.nbRequests=toSize(option, value, 1); ++i;
+			} else if(option=="--window") {
+				options.window=toSize(option, value, 1); ++i;
+			} else
+				throw std::runtime_error("unknown option "+option);
+		}
+
+		std::vector<std::string> requests(readRequests(options));
+		if(requests.empty())
+			throw std::runtime_error("the corpus is empty");
+
+		std::vector<ConnectionResult> results(options.nbConnections);
+		std::vector<std::thread> threads;
+		auto start(Clock::now());
+		for(size_t c(0); c<options.nbConnections; ++c)
+			threads.emplace_back(runConnection, std::cref(options), std::cref(requests),
+					c*requests.size()/options.nbConnections, std::ref(results[c]));
+		for(auto & thread : threads)
+			thread.join();
+		double seconds(std::chrono::duration<double>(Clock::now()-start).count());
+
+		std::vector<uint64_t> latencies;
+		size_t nbErrors(0);
+		for(auto const& result : results) {
+			if(!result.failure.empty())
+				throw std::runtime_error(result.failure);
+			latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+			nbErrors += result.nbErrors;
+		}
+		std::sort(latencies.begin(), latencies.end());
+
+		std::ofstream file;
+		if(!options.output.empty()) {
+			file.open(options.output);
+			if(!file)
+				throw std::runtime_error("could not open "+options.output);
+		}
+		std::ostream& os(options.output.empty() ? std::cout : file);
+		// nearest rank percentiles
+		os << "{\"connections\": " << options.nbConnections
+				<< ", \"window\": " << options.window
+				<< ", \"requests\": " << latencies.size()
+				<< ", \"errors\": " << nbErrors
+				<< ", \"p50_us\": " << (latencies.empty() ? 0 : latencies[(latencies.size()-1)/2]/1000)
+				<< ", \"p99_us\": " << (latencies.empty() ? 0 : latencies[(latencies.size()*99+99)/100-1]/1000)
+				<< ", \"max_us\": " << (latencies.empty() ? 0 : latencies.back()/1000)
+				<< ", \"throughput_per_s\": " << latencies.size()/seconds << "}" << std::endl;
+
+	} catch(std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+}
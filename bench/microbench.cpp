@@ -0,0 +1,244 @@
+/******************************************************************************
+ * Microbenchmarks of the core operations of Sudoku and DynamicBitset.
+ *
+ * Each operation is timed in batches at several side lengths, only the
+ * operation itself is inside the timed region. Reports the time and the
+ * number of heap allocations per operation as JSON. Allocations are
+ * counted by AllocationCounter, so they are only reported if the program
+ * is built with SUDOKU_COUNT_ALLOCATIONS (as done by "make bench").
+ *
+ * usage: microbench [--output <file>] [--batches <n>]
+ *****************************************************************************/
+
+#include "../Sudoku.h"
+#include "../DynamicBitset.h"
+#include "../PackedSudoku.h"
+#include "../SudokuWriter.h"
+#include "../AllocationCounter.h"
+#include "BenchOptions.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// keeps the compiler from optimizing the measured operations away
+volatile size_t sink(0);
+
+struct Result {
+	double nsPerOp;
+	double allocationsPerOp;
+};
+
+/*
+ * Runs setup() and then run() for the given number of batches. Only run()
+ * is timed, it has to perform nbOps operations.
+ */
+template <typename Setup, typename Run>
+Result measure(size_t nbBatches, size_t nbOps, Setup setup, Run run) {
+	uint64_t nanoseconds(0);
+	size_t allocations(0);
+	// one batch as warmup
+	setup();
+	run();
+	for(size_t b(0); b<nbBatches; ++b) {
+		setup();
+		size_t allocationsBefore(AllocationCounter::count());
+		auto start(std::chrono::steady_clock::now());
+		run();
+		nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now()-start).count();
+		allocations += AllocationCounter::count()-allocationsBefore;
+	}
+	double nbTotal(static_cast<double>(nbBatches*nbOps));
+	return Result{nanoseconds/nbTotal, allocations/nbTotal};
+}
+
+class Reporter {
+public:
+	explicit Reporter(std::ostream& os) : m_os(os) {m_os << "[";}
+	~Reporter() {m_os << "\n]" << std::endl;}
+
+	void report(char const* operation, size_t sideLength, Result const& result) {
+		m_os << (m_first ? "\n" : ",\n") << "  {\"operation\": \"" << operation
+				<< "\", \"sideLength\": " << sideLength
+				<< ", \"ns_per_op\": " << result.nsPerOp
+				<< ", \"allocations_per_op\": " << result.allocationsPerOp << "}";
+		m_first=false;
+	}
+
+private:
+	std::ostream& m_os;
+	bool m_first = true;
+};
+
+// a puzzle with every second field of the solution given
+Sudoku halfFilled(Sudoku const& solution) {
+	Sudoku sudoku(solution.sideLength(), solution.blockWidth());
+	for(size_t f(0); f<solution.nbFields(); f+=2)
+		sudoku.enterSolution(f, solution.getSolution(f));
+	return sudoku;
+}
+
+void benchSudoku(size_t sideLength, size_t nbBatches, Reporter& reporter) {
+	Sudoku solution(sideLength);
+	solution.trivialSolution();
+	Sudoku const empty(sideLength, solution.blockWidth());
+	Sudoku const puzzle(halfFilled(solution));
+	size_t nbFields(solution.nbFields());
+	Sudoku work;
+
+	reporter.report("Sudoku::enterSolution", sideLength, measure(nbBatches, nbFields,
+			[&] {work=empty;},
+			[&] {
+				for(size_t f(0); f<nbFields; ++f)
+					work.enterSolution(f, solution.getSolution(f));
+			}));
+
+	reporter.report("Sudoku::clearSolution", sideLength, measure(nbBatches, nbFields,
+			[&] {work=solution;},
+			[&] {
+				for(size_t f(0); f<nbFields; ++f)
+					work.clearSolution(f);
+			}));
+
+	std::vector<size_t> candidates;
+	reporter.report("Sudoku::getCandidates", sideLength, measure(nbBatches, nbFields,
+			[&] {work=puzzle;},
+			[&] {
+				for(size_t f(0); f<nbFields; ++f) {
+					work.getCandidates(f, candidates);
+					sink += candidates.size();
+				}
+			}));
+
+	size_t const nbCopies(16);
+	reporter.report("Sudoku::Sudoku(Sudoku const&)", sideLength, measure(nbBatches, nbCopies,
+			[] {},
+			[&] {
+				for(size_t i(0); i<nbCopies; ++i) {
+					Sudoku copy(puzzle);
+					sink += copy.nbSolved();
+				}
+			}));
+
+	std::ostringstream text;
+	text << puzzle;
+	std::string const input(text.str());
+	reporter.report("operator>>(istream, Sudoku)", sideLength, measure(nbBatches, 1,
+			[] {},
+			[&] {
+				std::istringstream stream(input);
+				stream >> work;
+				sink += work.nbSolved();
+			}));
+
+	// the packed file image of the puzzle, as it would be mapped
+	std::string const fileName("microbench.sdkp");
+	{
+		PackedSudokuWriter writer(fileName, sideLength, puzzle.blockWidth());
+		writer.write(puzzle);
+		writer.close();
+	}
+	{
+		PackedSudokuReader reader(fileName);
+		reporter.report("PackedSudokuReader::load", sideLength, measure(nbBatches, 1,
+				[] {},
+				[&] {
+					reader.load(0, work);
+					sink += work.nbSolved();
+				}));
+	}
+	std::remove(fileName.c_str());
+
+	SudokuWriter writer;
+	reporter.report("SudokuWriter::appendGrid", sideLength, measure(nbBatches, 1,
+			[&] {writer.clear();},
+			[&] {
+				writer.appendGrid(puzzle);
+				sink += writer.size();
+			}));
+}
+
+void benchBitset(size_t sideLength, size_t nbBatches, Reporter& reporter) {
+	size_t const nbBits(sideLength*sideLength);
+	DynamicBitset<> bitset(nbBits);
+
+	reporter.report("DynamicBitset::set", sideLength, measure(nbBatches, nbBits,
+			[&] {bitset.reset();},
+			[&] {
+				for(size_t i(0); i<nbBits; ++i)
+					bitset.set(i);
+			}));
+
+	reporter.report("DynamicBitset::reset", sideLength, measure(nbBatches, nbBits,
+			[&] {bitset.set();},
+			[&] {
+				for(size_t i(0); i<nbBits; ++i)
+					bitset.reset(i);
+			}));
+
+	// every third bit set
+	auto pattern = [&] {
+		bitset.reset();
+		for(size_t i(0); i<nbBits; i+=3)
+			bitset.set(i);
+	};
+
+	size_t const nbCounts(256);
+	reporter.report("DynamicBitset::count", sideLength, measure(nbBatches, nbCounts,
+			pattern,
+			[&] {
+				for(size_t i(0); i<nbCounts; ++i)
+					sink += bitset.count();
+			}));
+
+	std::vector<size_t> indices;
+	reporter.report("DynamicBitset::getIndices", sideLength, measure(nbBatches, 1,
+			pattern,
+			[&] {
+				bitset.getIndices(indices);
+				sink += indices.size();
+			}));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	try {
+		std::string output;
+		size_t nbBatches(200);
+		for(int i=1; i<argc; i++) {
+			std::string option(argv[i]);
+			char const* value(i+1<argc ? argv[i+1] : nullptr);
+			if(option=="--output") {
+				if(!value) throw std::runtime_error("--output needs a value");
+				output=value; ++i;
+			} else if(option=="--batches") {
+				nbBatches=toSize(option, value, 1); ++i;
+			} else
+				throw std::runtime_error("unknown option "+option);
+		}
+
+		std::ofstream file;
+		if(!output.empty()) {
+			file.open(output);
+			if(!file)
+				throw std::runtime_error("could not open "+output);
+		}
+		Reporter reporter(output.empty() ? std::cout : file);
+		for(size_t sideLength : {4, 9, 16, 25, 36}) {
+			benchSudoku(sideLength, nbBatches, reporter);
+			benchBitset(sideLength, nbBatches, reporter);
+		}
+
+	} catch(std::exception &e) {
+		std::cerr << "ERROR: " << e.what() << std::endl;
+		return 1;
+	}
+}
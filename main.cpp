@@ -1,8 +1,15 @@
 #include "SudokuGenerator.h"
 #include "SudokuSolver.h"
+#include "FixedSudoku.h"
 #include "DynamicBitset.h"
+#include "SudokuServer.h"
+#include "PackedSudoku.h"
+#include "SudokuWriter.h"
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 #include <stdlib.h>
 
 GridPoint indexToXy(size_t i, size_t sideLen) {
@@ -12,12 +19,42 @@ GridPoint indexToXy(size_t i, size_t sideLen) {
 	);
 }
 
+uint64_t parseSeed(char const* text) {
+	// a seed of 0 would mean "no seed", see SudokuSolver::Settings::randomSeed
+	uint64_t seed(std::stoull(text));
+	if(seed==0)
+		throw std::runtime_error("the seed must not be 0");
+	return seed;
+}
+
+// a number from 1 to max, named in the error messages
+size_t parsePositive(char const* text, std::string const& name, size_t max) {
+	// std::stoul would silently wrap a negative number around
+	std::string number(text);
+	if(number.empty() || number.find_first_not_of("0123456789")!=std::string::npos)
+		throw std::runtime_error("could not interpret "+number+" as "+name);
+	size_t value(0);
+	try {
+		value=std::stoul(number);
+	} catch(std::out_of_range &) {
+		throw std::runtime_error("the "+name+" "+number+" is too large");
+	}
+	if(value==0)
+		throw std::runtime_error("the "+name+" must not be 0");
+	if(value>max)
+		throw std::runtime_error("the "+name+" must not exceed "+std::to_string(max));
+	return value;
+}
+
 int main(int argc, char** argv) {
 	try {
 		if(argc<2) {
 			std::cout << "input format:" << std::endl;
-			std::cout << "solve <file>" << std::endl;
-			std::cout << "generate <size> <difficulty>" << std::endl;
+			std::cout << "solve <file> [difficulty] [--stats] [--seed <n>]" << std::endl;
+			std::cout << "generate <size> <difficulty> [--seed <n>]" << std::endl;
+			std::cout << "count <file> [limit]" << std::endl;
+			std::cout << "serve <address> [threads]" << std::endl;
+			std::cout << "pack <input file> <output file>" << std::endl;
 			return 1;
 		}
 
@@ -45,6 +82,12 @@ int main(int argc, char** argv) {
 				settings = SudokuGenerator::Settings::extreme;
 			else
 				throw std::runtime_error("could not interpret "+std::string(argv[3])+" as difficulty");
+			for(int i=4; i<argc; i++) {
+				if(std::string(argv[i])=="--seed" && i+1<argc)
+					settings.randomSeed(parseSeed(argv[++i]));
+				else
+					throw std::runtime_error("unknown argument "+std::string(argv[i]));
+			}
 
 			SudokuGenerator generator(
 					settings,
@@ -63,21 +106,39 @@ int main(int argc, char** argv) {
 
 		} else if(std::string(argv[1])=="solve") {
 
+			if(argc<3)
+				throw std::runtime_error("solve needs an additional argument: <file>");
+			bool printStats(false);
+			std::string difficulty;
+			uint64_t seed(0);
+			for(int i=3; i<argc; i++) {
+				if(std::string(argv[i])=="--stats")
+					printStats=true;
+				else if(std::string(argv[i])=="--seed" && i+1<argc)
+					seed=parseSeed(argv[++i]);
+				else
+					difficulty=argv[i];
+			}
+
 			SudokuSolver::Settings settings;
-			if(argc>3) {
-				if(std::string(argv[3])=="easy")
+			if(!difficulty.empty()) {
+				if(difficulty=="easy")
 					settings = SudokuSolver::Settings::easy;
-				else if(std::string(argv[3])=="medium")
+				else if(difficulty=="medium")
 					settings = SudokuSolver::Settings::medium;
-				else if(std::string(argv[3])=="hard")
+				else if(difficulty=="hard")
 					settings = SudokuSolver::Settings::hard;
-				else if(std::string(argv[3])=="extreme")
+				else if(difficulty=="extreme")
 					settings = SudokuSolver::Settings::extreme;
 				else
-					throw std::runtime_error("could not interpret "+std::string(argv[3])+" as difficulty");
+					throw std::runtime_error("could not interpret "+difficulty+" as difficulty");
 			}
 
-			settings.print();
+			settings.randomSeed(seed);
+
+			// with --stats, stdout carries nothing but the JSON
+			if(!printStats)
+				settings.print();
 
 			std::ifstream file(argv[2]);
 			if(!file)
@@ -86,18 +147,79 @@ int main(int argc, char** argv) {
 			file >> sudoku;
 			SudokuSolver solver(settings,sudoku);
 			SudokuSolver::Result result = solver.solve();
-			if(result==SudokuSolver::Result::solved) {
-				std::cout << "found " << solver.getSolved().size() << " solution(s):" << std::endl;
+			if(printStats) {
+				std::cout << "{\n  \"result\": \"" << result << "\",\n"
+						<< "  \"solutions\": " << solver.getSolved().size() << ",\n";
+				solver.getStats().printJsonMembers(std::cout);
+				std::cout << "}" << std::endl;
+			} else if(result==SudokuSolver::Result::solved) {
+				// all solutions are formatted into one buffer and written at once
+				SudokuWriter writer;
+				writer.append("found "+std::to_string(solver.getSolved().size())+" solution(s):\n");
 				for(size_t i=0; i<solver.getSolved().size(); i++) {
-					std::cout << "solution " << i+1 << " with " <<
-							solver.getSolved()[i].nbGuesses() << " guesses :" << std::endl;
-					solver.getSolved()[i].print();
+					writer.append("solution "+std::to_string(i+1)+" with "
+							+std::to_string(solver.getSolved()[i].nbGuesses())+" guesses :\n");
+					writer.appendFramed(solver.getSolved()[i]);
 				}
+				writer.flush(std::cout);
 			} else {
 				std::cout << "No solution found. Final state: " << std::endl;
 				solver.getWorkingVersion().printCandidates();
 				solver.getWorkingVersion().print();
 			}
+		} else if(std::string(argv[1])=="count") {
+
+			if(argc<3)
+				throw std::runtime_error("count needs an additional argument: <file>");
+			size_t limit(2);
+			if(argc>3)
+				limit=parsePositive(argv[3], "limit", std::numeric_limits<size_t>::max());
+
+			std::ifstream file(argv[2]);
+			if(!file)
+				throw std::runtime_error("could not open file "+std::string(argv[2]));
+			Sudoku sudoku;
+			file >> sudoku;
+			Sudoku solution;
+			size_t nbSolutions = countSolutionsFixed(sudoku, limit, &solution);
+			std::cout << "found " << nbSolutions << " solution(s)";
+			if(nbSolutions>=limit)
+				std::cout << " (limit reached)";
+			std::cout << std::endl;
+			if(nbSolutions>0) {
+				std::cout << "first solution:" << std::endl;
+				solution.print();
+			}
+		} else if(std::string(argv[1])=="serve") {
+
+			if(argc<3)
+				throw std::runtime_error("serve needs an additional argument: <address>");
+			SudokuServer::Options options;
+			options.address=argv[2];
+			if(argc>3)
+				options.nbThreads=parsePositive(argv[3], "number of threads", 1024);
+			SudokuServer server(options);
+			std::cout << "listening on " << options.address << std::endl;
+			server.run();
+		} else if(std::string(argv[1])=="pack") {
+
+			if(argc<4)
+				throw std::runtime_error("pack needs two additional arguments: <input file> <output file>");
+			std::ifstream file(argv[2]);
+			if(!file)
+				throw std::runtime_error("could not open file "+std::string(argv[2]));
+			std::unique_ptr<PackedSudokuWriter> writer;
+			Sudoku sudoku;
+			while(file >> std::ws && !file.eof()) {
+				file >> sudoku;
+				if(!writer)
+					writer.reset(new PackedSudokuWriter(argv[3], sudoku.sideLength(), sudoku.blockWidth()));
+				writer->write(sudoku);
+			}
+			if(!writer)
+				throw std::runtime_error("no sudokus in "+std::string(argv[2]));
+			writer->close();
+			std::cout << "packed " << writer->nbWritten() << " sudoku(s)" << std::endl;
 		} else {
 			throw std::runtime_error("unknown keyword "+std::string(argv[1]));
 		}